@@ -0,0 +1,528 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月19日  16:05:40
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: base64.hxx
+//  描述: Base64 编解码（标准与 URL 安全字母表），AVX2/SSSE3 加速，支持流式分块
+// **************************************************************************/
+#pragma once
+
+#include "ustring_view.hxx"
+#include "cpu_features.hxx"
+#include <cstring>
+#include <string>
+
+/**
+ * \brief Base64 字母表
+ */
+enum class base64_alphabet
+{
+    standard,   //'+' '/'
+    url_safe    //'-' '_'
+};
+
+namespace base64_detail {
+
+    /**
+     * \brief 编解码表
+     */
+    struct table {
+        char        enc[64];
+        signed char dec[256];
+        char        c62;
+        char        c63;
+
+        explicit table(base64_alphabet a) {
+            const char *base = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+            c62 = a == base64_alphabet::standard ? '+' : '-';
+            c63 = a == base64_alphabet::standard ? '/' : '_';
+            for (int i = 0; i < 62; ++i)
+                enc[i] = base[i];
+            enc[62] = c62;
+            enc[63] = c63;
+            for (int i = 0; i < 256; ++i)
+                dec[i] = -1;
+            for (int i = 0; i < 64; ++i)
+                dec[static_cast<uchar>(enc[i])] = static_cast<signed char>(i);
+        }
+
+        static const table &get(base64_alphabet a) {
+            static const table std_table(base64_alphabet::standard);
+            static const table url_table(base64_alphabet::url_safe);
+            return a == base64_alphabet::standard ? std_table : url_table;
+        }
+    };
+
+    /**
+     * \brief 标量编码，n 必须是3的倍数
+     */
+    inline void encode_scalar(const uchar *&in, size_t &n, char *&out, const table &t) {
+        while (n >= 3) {
+            uint v = (static_cast<uint>(in[0]) << 16) | (static_cast<uint>(in[1]) << 8) | in[2];
+            out[0] = t.enc[v >> 18];
+            out[1] = t.enc[(v >> 12) & 0x3F];
+            out[2] = t.enc[(v >> 6) & 0x3F];
+            out[3] = t.enc[v & 0x3F];
+            in += 3;
+            n -= 3;
+            out += 4;
+        }
+    }
+
+    /**
+     * \brief 标量解码，n 必须是4的倍数，不含填充
+     * \return 遇到非法字符返回false
+     */
+    inline bool decode_scalar(const char *&in, size_t &n, uchar *&out, const table &t) {
+        while (n >= 4) {
+            auto a = t.dec[static_cast<uchar>(in[0])];
+            auto b = t.dec[static_cast<uchar>(in[1])];
+            auto c = t.dec[static_cast<uchar>(in[2])];
+            auto d = t.dec[static_cast<uchar>(in[3])];
+            if ((a | b | c | d) < 0)
+                return false;
+            uint v = (static_cast<uint>(a) << 18) | (static_cast<uint>(b) << 12)
+                | (static_cast<uint>(c) << 6) | static_cast<uint>(d);
+            out[0] = static_cast<uchar>(v >> 16);
+            out[1] = static_cast<uchar>(v >> 8);
+            out[2] = static_cast<uchar>(v);
+            in += 4;
+            n -= 4;
+            out += 3;
+        }
+        return true;
+    }
+
+#ifdef BU_ARCH_X64
+    /**
+     * \brief SSSE3 编码，每次读16字节、消耗12字节、输出16个字符
+     */
+    BU_TARGET("ssse3")
+    inline void encode_ssse3(const uchar *&in, size_t &n, char *&out, const table &t) {
+        const auto shuf = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+        const auto lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, static_cast<char>(t.c62 - 62),
+            static_cast<char>(t.c63 - 63), 'A', 0, 0);
+        while (n >= 16) {
+            auto v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in)), shuf);
+            /*把每3个字节拆成4个6位索引*/
+            auto t0 = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+            auto t1 = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+            auto idx = _mm_or_si128(t0, t1);
+            /*按索引区间查偏移量*/
+            auto r = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+            auto less = _mm_cmpgt_epi8(_mm_set1_epi8(26), idx);
+            r = _mm_or_si128(r, _mm_and_si128(less, _mm_set1_epi8(13)));
+            r = _mm_add_epi8(_mm_shuffle_epi8(lut, r), idx);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), r);
+            in += 12;
+            n -= 12;
+            out += 16;
+        }
+    }
+
+    /**
+     * \brief AVX2 编码，每次读28字节、消耗24字节、输出32个字符
+     */
+    BU_TARGET("avx2")
+    inline void encode_avx2(const uchar *&in, size_t &n, char *&out, const table &t) {
+        const auto shuf = _mm256_broadcastsi128_si256(
+            _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+        const auto lut = _mm256_broadcastsi128_si256(_mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            static_cast<char>(t.c62 - 62), static_cast<char>(t.c63 - 63), 'A', 0, 0));
+        while (n >= 28) {
+            auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+            auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 12));
+            auto v = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), shuf);
+            auto t0 = _mm256_mulhi_epu16(_mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00)),
+                _mm256_set1_epi32(0x04000040));
+            auto t1 = _mm256_mullo_epi16(_mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0)),
+                _mm256_set1_epi32(0x01000010));
+            auto idx = _mm256_or_si256(t0, t1);
+            auto r = _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+            auto less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), idx);
+            r = _mm256_or_si256(r, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+            r = _mm256_add_epi8(_mm256_shuffle_epi8(lut, r), idx);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), r);
+            in += 24;
+            n -= 24;
+            out += 32;
+        }
+    }
+
+    /**
+     * \brief SSSE3 解码，每次读16个字符、输出12字节（写16字节），遇到非法字符的块留给标量处理
+     */
+    BU_TARGET("ssse3")
+    inline void decode_ssse3(const char *&in, size_t &n, uchar *&out, const table &t) {
+        const auto pack_shuf = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        while (n >= 16) {
+            auto c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+            auto upper = _mm_andnot_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('Z')),
+                _mm_cmpgt_epi8(c, _mm_set1_epi8('A' - 1)));
+            auto lower = _mm_andnot_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('z')),
+                _mm_cmpgt_epi8(c, _mm_set1_epi8('a' - 1)));
+            auto digit = _mm_andnot_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('9')),
+                _mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)));
+            auto e62 = _mm_cmpeq_epi8(c, _mm_set1_epi8(t.c62));
+            auto e63 = _mm_cmpeq_epi8(c, _mm_set1_epi8(t.c63));
+            auto valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(_mm_or_si128(digit, e62), e63));
+            if (_mm_movemask_epi8(valid) != 0xFFFF)
+                return;
+            auto v = _mm_or_si128(
+                _mm_or_si128(_mm_and_si128(upper, _mm_sub_epi8(c, _mm_set1_epi8('A'))),
+                    _mm_and_si128(lower, _mm_sub_epi8(c, _mm_set1_epi8('a' - 26)))),
+                _mm_or_si128(_mm_and_si128(digit, _mm_add_epi8(c, _mm_set1_epi8(52 - '0'))),
+                    _mm_or_si128(_mm_and_si128(e62, _mm_set1_epi8(62)), _mm_and_si128(e63, _mm_set1_epi8(63)))));
+            /*每4个6位值合并成3个字节*/
+            auto merged = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+            auto packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(packed, pack_shuf));
+            in += 16;
+            n -= 16;
+            out += 12;
+        }
+    }
+
+    /**
+     * \brief AVX2 解码，每次读32个字符、输出24字节（写32字节）
+     */
+    BU_TARGET("avx2")
+    inline void decode_avx2(const char *&in, size_t &n, uchar *&out, const table &t) {
+        const auto pack_shuf = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        const auto pack_perm = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+        while (n >= 32) {
+            auto c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in));
+            auto upper = _mm256_andnot_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('Z')),
+                _mm256_cmpgt_epi8(c, _mm256_set1_epi8('A' - 1)));
+            auto lower = _mm256_andnot_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('z')),
+                _mm256_cmpgt_epi8(c, _mm256_set1_epi8('a' - 1)));
+            auto digit = _mm256_andnot_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('9')),
+                _mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)));
+            auto e62 = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(t.c62));
+            auto e63 = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(t.c63));
+            auto valid = _mm256_or_si256(_mm256_or_si256(upper, lower),
+                _mm256_or_si256(_mm256_or_si256(digit, e62), e63));
+            if (_mm256_movemask_epi8(valid) != -1)
+                return;
+            auto v = _mm256_or_si256(
+                _mm256_or_si256(_mm256_and_si256(upper, _mm256_sub_epi8(c, _mm256_set1_epi8('A'))),
+                    _mm256_and_si256(lower, _mm256_sub_epi8(c, _mm256_set1_epi8('a' - 26)))),
+                _mm256_or_si256(_mm256_and_si256(digit, _mm256_add_epi8(c, _mm256_set1_epi8(52 - '0'))),
+                    _mm256_or_si256(_mm256_and_si256(e62, _mm256_set1_epi8(62)),
+                        _mm256_and_si256(e63, _mm256_set1_epi8(63)))));
+            auto merged = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+            auto packed = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+            packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(packed, pack_shuf), pack_perm);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), packed);
+            in += 32;
+            n -= 32;
+            out += 24;
+        }
+    }
+#endif
+
+    /**
+     * \brief 解码输出需要预留的额外空间，SIMD 每次多写最多8字节
+     */
+    const size_t decode_slack = 8;
+
+    /**
+     * \brief 编码完整的3字节组，按 CPU 能力分派
+     */
+    inline void encode_full(const uchar *in, size_t n, char *out, const table &t) {
+#ifdef BU_ARCH_X64
+        auto &f = cpu_features::get();
+        if (f.avx2)
+            encode_avx2(in, n, out, t);
+        if (f.ssse3)
+            encode_ssse3(in, n, out, t);
+#endif
+        encode_scalar(in, n, out, t);
+    }
+
+    /**
+     * \brief 解码完整的4字符组，按 CPU 能力分派
+     * \return 输出结尾，遇到非法字符返回空指针
+     */
+    inline uchar *decode_full(const char *in, size_t n, uchar *out, const table &t) {
+#ifdef BU_ARCH_X64
+        auto &f = cpu_features::get();
+        if (f.avx2)
+            decode_avx2(in, n, out, t);
+        if (f.ssse3)
+            decode_ssse3(in, n, out, t);
+#endif
+        return decode_scalar(in, n, out, t) ? out : nullptr;
+    }
+}
+
+/**
+ * \brief 流式 Base64 编码器，不足3字节的尾部留到下一次或 finish()
+ */
+class base64_encoder final {
+public:
+    /**
+     * \brief 构造
+     * \param a 字母表
+     * \param pad 结尾是否补 '='
+     */
+    explicit base64_encoder(base64_alphabet a = base64_alphabet::standard, bool pad = true)
+        : tab(&base64_detail::table::get(a)), padding(pad) {}
+
+    /**
+     * \brief 编码一块数据，追加到 out
+     * \param v 数据
+     * \param out 输出
+     */
+    void update(ustring_view v, std::string &out) {
+        auto in = v.data();
+        auto n = v.size();
+        if (carry_len > 0) {
+            while (carry_len < 3 && n > 0) {
+                carry[carry_len++] = *in++;
+                --n;
+            }
+            if (carry_len < 3)
+                return;
+            emit(carry, 3, out);
+            carry_len = 0;
+        }
+        auto whole = n - n % 3;
+        emit(in, whole, out);
+        in += whole;
+        n -= whole;
+        while (n--)
+            carry[carry_len++] = *in++;
+    }
+
+    /**
+     * \brief 输出剩余字节与填充
+     * \param out 输出
+     */
+    void finish(std::string &out) {
+        if (carry_len == 0)
+            return;
+        uint v = static_cast<uint>(carry[0]) << 16;
+        if (carry_len > 1)
+            v |= static_cast<uint>(carry[1]) << 8;
+        out.push_back(tab->enc[v >> 18]);
+        out.push_back(tab->enc[(v >> 12) & 0x3F]);
+        if (carry_len > 1)
+            out.push_back(tab->enc[(v >> 6) & 0x3F]);
+        else if (padding)
+            out.push_back('=');
+        if (padding)
+            out.push_back('=');
+        carry_len = 0;
+    }
+
+    /**
+     * \brief 编码后长度
+     * \param n 原始长度
+     * \param pad 是否补 '='
+     * \return 编码后长度
+     */
+    static size_t encoded_size(size_t n, bool pad = true) {
+        return pad ? (n + 2) / 3 * 4 : n / 3 * 4 + (n % 3 ? n % 3 + 1 : 0);
+    }
+
+private:
+
+    void emit(const uchar *in, size_t n, std::string &out) {
+        if (n == 0)
+            return;
+        auto old = out.size();
+        out.resize(old + n / 3 * 4);
+        base64_detail::encode_full(in, n, &out[old], *tab);
+    }
+
+    const base64_detail::table  *tab;
+    bool                        padding;
+    uchar                       carry[3];
+    size_t                      carry_len{ 0 };
+};
+
+/**
+ * \brief 流式 Base64 解码器，不足4个字符的尾部留到下一次或 finish()，
+ * 结尾的 '=' 可有可无，但出现时必须完整
+ */
+class base64_decoder final {
+public:
+    /**
+     * \brief 构造
+     * \param a 字母表
+     */
+    explicit base64_decoder(base64_alphabet a = base64_alphabet::standard)
+        : tab(&base64_detail::table::get(a)) {}
+
+    /**
+     * \brief 解码一块字符，追加到 out
+     * \param p 字符
+     * \param n 字符个数
+     * \param out 输出
+     * \return 输入非法返回false，之后的调用都返回false
+     */
+    bool update(const char *p, size_t n, ustring &out) {
+        while (n > 0 && !failed) {
+            if (pads > 0 || *p == '=') {
+                pad(*p++, out);
+                --n;
+                continue;
+            }
+            if (carry_len > 0 || n < 4) {
+                carry[carry_len++] = *p++;
+                --n;
+                if (carry_len == 4) {
+                    emit(carry, 4, out);
+                    carry_len = 0;
+                }
+                continue;
+            }
+            /*找到第一个 '=' 之前的完整4字符组整块解码*/
+            auto run = static_cast<const char *>(std::memchr(p, '=', n));
+            auto len = run ? static_cast<size_t>(run - p) : n;
+            len -= len % 4;
+            if (len == 0) {
+                carry[carry_len++] = *p++;
+                --n;
+                continue;
+            }
+            emit(p, len, out);
+            p += len;
+            n -= len;
+        }
+        return !failed;
+    }
+
+    /**
+     * \brief 解码一块字符，追加到 out
+     * \param s 字符串
+     * \param out 输出
+     * \return 输入非法返回false
+     */
+    bool update(const std::string &s, ustring &out) { return update(s.data(), s.size(), out); }
+
+    /**
+     * \brief 结束解码，处理没有填充的尾部
+     * \param out 输出
+     * \return 输入完整合法返回true
+     */
+    bool finish(ustring &out) {
+        if (failed)
+            return false;
+        if (pads > 0)
+            return pads == expected_pads;
+        if (carry_len == 1)
+            return false;
+        if (carry_len > 1)
+            tail(out);
+        return !failed;
+    }
+
+private:
+
+    void emit(const char *p, size_t n, ustring &out) {
+        auto old = out.size();
+        out.resize(old + n / 4 * 3 + base64_detail::decode_slack);
+        auto end = base64_detail::decode_full(p, n, &out[old], *tab);
+        if (!end) {
+            failed = true;
+            out.resize(old);
+            return;
+        }
+        out.resize(static_cast<size_t>(end - out.data()));
+    }
+
+    /**
+     * \brief 解码最后不足4个字符的组
+     */
+    void tail(ustring &out) {
+        uint v = 0;
+        for (size_t i = 0; i < carry_len; ++i) {
+            auto d = tab->dec[static_cast<uchar>(carry[i])];
+            if (d < 0) {
+                failed = true;
+                return;
+            }
+            v |= static_cast<uint>(d) << (18 - 6 * i);
+        }
+        out.push_back(static_cast<uchar>(v >> 16));
+        if (carry_len == 3)
+            out.push_back(static_cast<uchar>(v >> 8));
+        carry_len = 0;
+    }
+
+    /**
+     * \brief 处理结尾的填充，第一个 '=' 出现时解码最后一组
+     */
+    void pad(char c, ustring &out) {
+        if (c != '=' || (pads == 0 && carry_len < 2)) {
+            failed = true;
+            return;
+        }
+        if (pads == 0) {
+            expected_pads = 4 - carry_len;
+            tail(out);
+        }
+        if (++pads > expected_pads)
+            failed = true;
+    }
+
+    const base64_detail::table  *tab;
+    char                        carry[4];
+    size_t                      carry_len{ 0 };
+    size_t                      pads{ 0 };
+    size_t                      expected_pads{ 0 };
+    bool                        failed{ false };
+};
+
+/**
+ * \brief Base64 一次性编解码
+ */
+class base64 final {
+public:
+    /**
+     * \brief 编码
+     * \param v 数据，ustring、shared_ustring 均可
+     * \param a 字母表
+     * \param pad 结尾是否补 '='
+     * \return 编码结果
+     */
+    static std::string encode(ustring_view v, base64_alphabet a = base64_alphabet::standard, bool pad = true) {
+        std::string out;
+        out.reserve(base64_encoder::encoded_size(v.size(), pad));
+        base64_encoder e(a, pad);
+        e.update(v, out);
+        e.finish(out);
+        return out;
+    }
+
+    /**
+     * \brief 解码，追加到 out
+     * \param s 编码字符串
+     * \param out 输出
+     * \param a 字母表
+     * \return 输入合法返回true
+     */
+    static bool decode(const std::string &s, ustring &out, base64_alphabet a = base64_alphabet::standard) {
+        base64_decoder d(a);
+        return d.update(s, out) && d.finish(out);
+    }
+
+    /**
+     * \brief 解码
+     * \param s 编码字符串
+     * \param a 字母表
+     * \return 解码结果，输入非法返回空串
+     */
+    static ustring decode(const std::string &s, base64_alphabet a = base64_alphabet::standard) {
+        ustring out;
+        if (!decode(s, out, a))
+            out.clear();
+        return out;
+    }
+};
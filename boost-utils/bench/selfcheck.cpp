@@ -0,0 +1,1630 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月22日  10:12:36
+//  工程: boost-utils
+//  程序: selfcheck
+//  文件: selfcheck.cpp
+//  描述: 各组件的自检，对照参考实现或朴素算法，由 ctest 运行
+// **************************************************************************/
+
+#include "../checksum.hxx"
+#include "../base64.hxx"
+#include "../timing_wheel.hxx"
+#include "../frame_decoder.hxx"
+#include "../byte_search.hxx"
+#include "../expiring_cache.hxx"
+#include "../byte_ops.hxx"
+#include "../hexdump.hxx"
+#include "../ring_buffer.hxx"
+#include "../shared_ustring.hxx"
+#include "../parallel_ops.hxx"
+#include "../buffer_pool.hxx"
+#include "../mapped_file.hxx"
+#include "../timer_stats.hxx"
+#include "../forever_timer.hxx"
+#include "../sharded_timer.hxx"
+#include "../timerfd_driver.hxx"
+#include <boost/log/core/core.hpp>
+#include <boost/log/expressions.hpp>
+#include <boost/log/sinks/sync_frontend.hpp>
+#include <boost/log/sinks/text_ostream_backend.hpp>
+#include <boost/make_shared.hpp>
+#include "../logger/binlog.hxx"
+#include "../logger/log_format.hxx"
+#include "../logger/logger.hxx"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief 失败的检查数
+ */
+static size_t failures = 0;
+
+#define SELFCHECK(cond, ...)                                    \
+    do {                                                        \
+        if (!(cond)) {                                          \
+            if (++failures <= 20) {                             \
+                std::printf("%s:%d: FAILED %s: ", __FILE__, __LINE__, #cond); \
+                std::printf(__VA_ARGS__);                       \
+                std::printf("\n");                              \
+            }                                                   \
+        }                                                       \
+    } while (0)
+
+/**
+ * \brief 逐位计算的 CRC32C 参考实现
+ */
+static uint crc32c_ref(const uchar *p, size_t n) {
+    uint crc = ~0u;
+    while (n--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; ++k)
+            crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+/**
+ * \brief 逐字节的 Base64 参考编码
+ */
+static std::string base64_ref(const uchar *p, size_t n, base64_alphabet a, bool pad) {
+    std::string enc = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+    enc += a == base64_alphabet::standard ? "+/" : "-_";
+    std::string out;
+    size_t i = 0;
+    for (; i + 3 <= n; i += 3) {
+        uint v = (static_cast<uint>(p[i]) << 16) | (static_cast<uint>(p[i + 1]) << 8) | p[i + 2];
+        for (int k = 18; k >= 0; k -= 6)
+            out.push_back(enc[(v >> k) & 0x3F]);
+    }
+    if (i < n) {
+        uint v = static_cast<uint>(p[i]) << 16;
+        if (i + 1 < n)
+            v |= static_cast<uint>(p[i + 1]) << 8;
+        out.push_back(enc[(v >> 18) & 0x3F]);
+        out.push_back(enc[(v >> 12) & 0x3F]);
+        if (i + 1 < n)
+            out.push_back(enc[(v >> 6) & 0x3F]);
+        if (pad)
+            out.append(i + 1 < n ? 1 : 2, '=');
+    }
+    return out;
+}
+
+static void check_crc32c(std::mt19937_64 &rng) {
+    const char *digits = "123456789";
+    auto v = crc32c::compute(ustring_view(reinterpret_cast<const uchar *>(digits), 9));
+    SELFCHECK(v == 0xE3069283u, "crc32c(\"123456789\") = %08x", v);
+
+    /*各种长度与起始对齐，覆盖折叠路径的分块边界*/
+    std::vector<uchar> buf(1 << 20);
+    for (auto &c : buf)
+        c = static_cast<uchar>(rng());
+    std::vector<size_t> lengths;
+    for (size_t n = 0; n <= 4096; ++n)
+        lengths.push_back(n);
+    for (size_t n = 4097; n < buf.size() - 8; n = n * 5 / 4 + 1)
+        lengths.push_back(n);
+    lengths.push_back(buf.size() - 8);
+    for (auto n : lengths) {
+        auto offset = n % 8;
+        auto p = buf.data() + offset;
+        auto expect = crc32c_ref(p, n);
+        auto got = crc32c::compute(ustring_view(p, n));
+        SELFCHECK(got == expect, "len %zu offset %zu: %08x != %08x", n, offset, got, expect);
+
+        /*分两段计算与合并*/
+        auto cut = n ? static_cast<size_t>(rng() % (n + 1)) : 0;
+        auto stream = crc32c().update(p, cut).update(p + cut, n - cut).value();
+        SELFCHECK(stream == expect, "len %zu split %zu: %08x != %08x", n, cut, stream, expect);
+        auto a = crc32c::compute(ustring_view(p, cut));
+        auto b = crc32c::compute(ustring_view(p + cut, n - cut));
+        auto combined = crc32c::combine(a, b, n - cut);
+        SELFCHECK(combined == expect, "len %zu combine at %zu: %08x != %08x", n, cut, combined, expect);
+    }
+    std::printf("crc32c: %zu lengths ok\n", lengths.size());
+}
+
+static void check_base64(std::mt19937_64 &rng) {
+    const size_t max_len = 100000;
+    ustring src(max_len);
+    for (size_t i = 0; i < max_len; ++i)
+        src[i] = static_cast<uchar>(rng());
+
+    const base64_alphabet alphabets[] = { base64_alphabet::standard, base64_alphabet::url_safe };
+    for (auto a : alphabets) {
+        auto name = a == base64_alphabet::standard ? "standard" : "url_safe";
+        ustring back;
+        for (size_t n = 0; n <= max_len; ++n) {
+            auto pad = (n & 1) == 0;
+            auto enc = base64::encode(ustring_view(src.data(), n), a, pad);
+            /*参考编码代价与长度成正比，长输入只抽查*/
+            if (n <= 4096 || n % 997 == 0 || n + 3 > max_len) {
+                auto expect = base64_ref(src.data(), n, a, pad);
+                SELFCHECK(enc == expect, "%s len %zu: encode mismatch", name, n);
+            }
+            back.clear();
+            auto ok = base64::decode(enc, back, a);
+            SELFCHECK(ok && back.size() == n && std::memcmp(back.data(), src.data(), n) == 0,
+                "%s len %zu: round trip failed", name, n);
+        }
+        std::printf("base64 %s: lengths 0..%zu ok\n", name, max_len);
+    }
+}
+
+/**
+ * \brief 时间轮模糊测试的节点
+ */
+struct fuzz_timer : timer_node {
+    size_t  id{ 0 };
+};
+
+static void check_timing_wheel(std::mt19937_64 &rng) {
+    const size_t timers = 512;
+    const size_t steps = 200000;
+    std::vector<fuzz_timer> nodes(timers);
+    /*参考：每个节点的到期刻度，不在轮中为 never*/
+    std::vector<qword> expect(timers, timing_wheel::never());
+    std::multimap<qword, size_t> pending;
+    timing_wheel wheel(rng() % 1000);
+    for (size_t i = 0; i < timers; ++i)
+        nodes[i].id = i;
+
+    auto unpend = [&](size_t id) {
+        auto range = pending.equal_range(expect[id]);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == id) {
+                pending.erase(it);
+                break;
+            }
+        }
+        expect[id] = timing_wheel::never();
+    };
+    auto pick_delay = [&]() -> qword {
+        /*多数落在低层，少数跨越高层与整轮*/
+        switch (rng() % 4) {
+        case 0: return rng() % 64;
+        case 1: return rng() % 4096;
+        case 2: return rng() % (qword(1) << 24);
+        default: return rng() % (qword(1) << 40);
+        }
+    };
+
+    size_t fired_total = 0;
+    for (size_t step = 0; step < steps; ++step) {
+        auto op = rng() % 8;
+        auto id = static_cast<size_t>(rng() % timers);
+        if (op < 4) {
+            auto at = wheel.current() + pick_delay();
+            if (rng() % 16 == 0 && wheel.current() > 0)
+                at = wheel.current() - 1;
+            if (expect[id] != timing_wheel::never())
+                unpend(id);
+            wheel.schedule(nodes[id], at);
+            expect[id] = at < wheel.current() ? wheel.current() : at;
+            pending.emplace(expect[id], id);
+        }
+        else if (op < 5) {
+            auto was = expect[id] != timing_wheel::never();
+            SELFCHECK(wheel.cancel(nodes[id]) == was, "step %zu: cancel %zu", step, id);
+            if (was)
+                unpend(id);
+        }
+        else {
+            auto now = wheel.current() + pick_delay() / (op == 7 ? 1 : 64);
+            qword last = 0;
+            size_t fired = 0;
+            wheel.advance(now, [&](timer_node &n) {
+                auto &t = static_cast<fuzz_timer &>(n);
+                SELFCHECK(expect[t.id] != timing_wheel::never(), "step %zu: %zu fired while idle", step, t.id);
+                SELFCHECK(expect[t.id] <= now, "step %zu: %zu fired early", step, t.id);
+                SELFCHECK(expect[t.id] >= last, "step %zu: %zu fired out of order", step, t.id);
+                last = expect[t.id];
+                unpend(t.id);
+                ++fired;
+                /*回调中重新安排到 now 之后*/
+                if (rng() % 4 == 0) {
+                    auto at = now + 1 + pick_delay();
+                    wheel.schedule(t, at);
+                    expect[t.id] = at;
+                    pending.emplace(at, t.id);
+                }
+            });
+            SELFCHECK(wheel.current() == now + 1, "step %zu: current %llu after advance to %llu", step,
+                static_cast<unsigned long long>(wheel.current()), static_cast<unsigned long long>(now));
+            SELFCHECK(pending.empty() || pending.begin()->first > now, "step %zu: timer %zu missed", step,
+                pending.begin()->second);
+            fired_total += fired;
+        }
+        SELFCHECK(wheel.size() == pending.size(), "step %zu: size %zu != %zu", step, wheel.size(), pending.size());
+        auto next = wheel.next_expiry();
+        if (pending.empty())
+            SELFCHECK(next == timing_wheel::never(), "step %zu: next_expiry on empty wheel", step);
+        else
+            SELFCHECK(next >= wheel.current() && next <= pending.begin()->first, "step %zu: next_expiry past earliest",
+                step);
+    }
+    std::printf("timing_wheel: %zu steps, %zu fired ok\n", steps, fired_total);
+}
+
+/**
+ * \brief 按 binlog 写入记录的方式编码参数，再用记录中的解码函数格式化
+ */
+template<class... Ps>
+static std::string binlog_encode_decode(const binlog_site &site, const Ps &...args) {
+    size_t bytes = 0;
+    using swallow = int[];
+    (void)swallow{ 0, (bytes += binlog_detail::wire<Ps>::size(args), 0)... };
+    std::vector<uchar> buf(bytes + 1);
+    auto p = buf.data();
+    (void)swallow{ 0, (binlog_detail::wire<Ps>::put(p, args), 0)... };
+    (void)p;
+    return binlog_detail::decode<Ps...>(site, buf.data());
+}
+
+template<class... Args>
+static std::string binlog_roundtrip(const binlog_site &site, const Args &...args) {
+    return binlog_encode_decode<binlog_detail::prepared_t<Args>...>(site,
+        binlog_detail::codec<typename std::decay<Args>::type>::prepare(args)...);
+}
+
+static void check_binlog_codec() {
+    /*延迟格式化的 %p 须输出原指针，而不是解码出的临时字符串的地址*/
+    int x = 0;
+    const double d = 0;
+    unsigned char bytes[4] = {};
+    int *null_ptr = nullptr;
+    static const binlog_site site_p = { "%p %p %p %p", loglevel::Log_Info, "selfcheck", __FILE__, __LINE__ };
+    auto got = binlog_roundtrip(site_p, &x, &d, bytes, null_ptr);
+    auto expect = log_format::format(site_p.fmt, &x, &d, bytes, null_ptr);
+    SELFCHECK(got == expect, "binlog %%p: '%s' != '%s'", got.c_str(), expect.c_str());
+
+    static const binlog_site site_mix = { "%s|%d|%5.2f|%s|%x|%p", loglevel::Log_Info, "selfcheck", __FILE__, __LINE__ };
+    std::string text = "text";
+    got = binlog_roundtrip(site_mix, "literal", -42, 3.14159, text, 255u, static_cast<const void *>(text.data()));
+    expect = log_format::format(site_mix.fmt, "literal", -42, 3.14159, text, 255u, static_cast<const void *>(text.data()));
+    SELFCHECK(got == expect, "binlog mixed: '%s' != '%s'", got.c_str(), expect.c_str());
+
+    /*字符串的 %p 在编译期标记出来，BU_LOG_DEFERRED 下拒绝*/
+    static_assert(log_format_detail::checker<decltype(log_format_detail::types("s"))>::check("%p") ==
+        log_format_detail::string_pointer, "%p of a string must be flagged");
+    static_assert(log_format_detail::checker<decltype(log_format_detail::types("s", "t"))>::check("%p %d") ==
+        log_format_detail::bad_type, "later errors must win over string_pointer");
+    static_assert(log_format_detail::checker<decltype(log_format_detail::types(&x))>::check("%p") ==
+        log_format_detail::ok, "%p of a pointer is fine");
+    std::printf("binlog codec ok\n");
+}
+
+/**
+ * \brief 把数据按随机大小切块输入解码器，收集所有帧
+ */
+static std::vector<ustring> frame_feed(frame_decoder &dec, const ustring &wire, std::mt19937_64 &rng, size_t max_chunk,
+    ERRCODE &ec) {
+    std::vector<ustring> frames;
+    size_t off = 0;
+    while (off < wire.size() && !ec) {
+        auto n = std::min(wire.size() - off, static_cast<size_t>(1 + rng() % max_chunk));
+        dec.feed(ustring_view(wire.data() + off, n), [&](ustring_view f) { frames.emplace_back(f.data(), f.size()); },
+            ec);
+        off += n;
+    }
+    return frames;
+}
+
+static void check_frame_decoder(std::mt19937_64 &rng) {
+    const frame_length_type types[] = { frame_length_type::u16, frame_length_type::u32, frame_length_type::varint };
+    const char *names[] = { "u16", "u32", "varint" };
+    for (size_t t = 0; t < 3; ++t) {
+        frame_options opts;
+        opts.length_type = types[t];
+        opts.max_frame = types[t] == frame_length_type::u16 ? 60000 : 70000;
+
+        /*边界长度：空帧、varint 字节数变化处、最大帧*/
+        std::vector<size_t> lengths = { 0, 1, 127, 128, 255, 256, 16383, 16384, opts.max_frame };
+        for (size_t i = 0; i < 300; ++i)
+            lengths.push_back(rng() % 4 == 0 ? rng() % opts.max_frame : rng() % 300);
+        std::vector<ustring> expect;
+        ustring wire;
+        for (auto n : lengths) {
+            ustring payload(n);
+            for (auto &c : payload)
+                c = static_cast<uchar>(rng());
+            frame_decoder::append_frame(wire, make_view(payload), opts);
+            expect.push_back(std::move(payload));
+        }
+
+        /*逐字节、小块、大块与整块输入*/
+        const size_t chunks[] = { 1, 7, 4096, wire.size() };
+        for (auto max_chunk : chunks) {
+            frame_decoder dec(opts);
+            ERRCODE ec;
+            auto frames = frame_feed(dec, wire, rng, max_chunk, ec);
+            SELFCHECK(!ec, "frame %s chunk %zu: %s", names[t], max_chunk, ec.message().c_str());
+            SELFCHECK(frames == expect, "frame %s chunk %zu: %zu of %zu frames match", names[t], max_chunk,
+                frames.size(), expect.size());
+            SELFCHECK(dec.buffered() == 0, "frame %s chunk %zu: %zu bytes left", names[t], max_chunk, dec.buffered());
+        }
+
+        /*超长帧报 message_size，reset 后可继续使用*/
+        ustring big(opts.max_frame + 1);
+        for (auto max_chunk : chunks) {
+            ustring bad;
+            frame_decoder::append_frame(bad, make_view(big), opts);
+            frame_decoder dec(opts);
+            ERRCODE ec;
+            frame_feed(dec, bad, rng, max_chunk, ec);
+            SELFCHECK(ec == boost::system::errc::message_size, "frame %s chunk %zu: oversize gave '%s'", names[t],
+                max_chunk, ec.message().c_str());
+            dec.reset();
+            ec.clear();
+            auto frames = frame_feed(dec, wire, rng, 4096, ec);
+            SELFCHECK(!ec && frames == expect, "frame %s: decode after reset failed", names[t]);
+        }
+    }
+
+    /*varint 长度字段超出 64 位报 bad_message，无论是否跨块*/
+    frame_options opts;
+    opts.length_type = frame_length_type::varint;
+    const size_t chunks[] = { 1, 3, 11 };
+    for (auto max_chunk : chunks) {
+        ustring bad(11, 0xFF);
+        bad.push_back(0);
+        frame_decoder dec(opts);
+        ERRCODE ec;
+        frame_feed(dec, bad, rng, max_chunk, ec);
+        SELFCHECK(ec == boost::system::errc::bad_message, "varint overflow chunk %zu: got '%s'", max_chunk,
+            ec.message().c_str());
+    }
+    std::printf("frame_decoder ok\n");
+}
+
+/**
+ * \brief 小字母表的随机字节串，便于产生部分匹配与重叠匹配
+ */
+static ustring search_text(std::mt19937_64 &rng, size_t n) {
+    ustring out(n);
+    for (auto &c : out)
+        c = rng() % 64 == 0 ? static_cast<uchar>(rng()) : static_cast<uchar>('a' + rng() % 3);
+    return out;
+}
+
+/**
+ * \brief 朴素查找
+ */
+static size_t search_ref(const ustring &hay, const ustring &pat, size_t from) {
+    if (from > hay.size())
+        return byte_searcher::npos;
+    auto it = std::search(hay.begin() + from, hay.end(), pat.begin(), pat.end());
+    return it == hay.end() && !(pat.empty() && from == hay.size()) ? byte_searcher::npos
+        : static_cast<size_t>(it - hay.begin());
+}
+
+/**
+ * \brief 把缓冲区随机切分成若干段
+ */
+static std::vector<ustring_view> search_split(const ustring &hay, std::mt19937_64 &rng) {
+    std::vector<ustring_view> chain;
+    size_t off = 0;
+    while (off < hay.size()) {
+        auto n = std::min(hay.size() - off, static_cast<size_t>(rng() % 40));
+        chain.push_back(ustring_view(hay.data() + off, n));
+        off += n;
+    }
+    return chain;
+}
+
+static void check_byte_search(std::mt19937_64 &rng) {
+    size_t searches = 0;
+    for (size_t round = 0; round < 3000; ++round) {
+        auto hay = search_text(rng, rng() % 600);
+        /*模式取自文本或随机生成，覆盖单字节、SIMD 过滤与 Horspool 回退*/
+        ustring pat;
+        auto m = static_cast<size_t>(rng() % 48);
+        if (rng() % 2 && m <= hay.size()) {
+            auto at = rng() % (hay.size() - m + 1);
+            pat.assign(hay.data() + at, m);
+        }
+        else {
+            pat = search_text(rng, m);
+        }
+        byte_searcher searcher(make_view(pat));
+        for (size_t k = 0; k < 4; ++k) {
+            auto from = static_cast<size_t>(rng() % (hay.size() + 2));
+            auto expect = search_ref(hay, pat, from);
+            auto got = searcher.find(make_view(hay), from);
+            SELFCHECK(got == expect, "find len %zu pat %zu from %zu: %zu != %zu", hay.size(), m, from, got, expect);
+            ++searches;
+        }
+        auto chain = search_split(hay, rng);
+        auto expect = search_ref(hay, pat, 0);
+        auto got = searcher.find_chain(chain);
+        SELFCHECK(got == expect, "find_chain len %zu pat %zu in %zu segments: %zu != %zu", hay.size(), m,
+            chain.size(), got, expect);
+    }
+
+    /*多模式：对照每个模式逐位置比较得到的 (模式, 结束位置) 集合*/
+    for (size_t round = 0; round < 300; ++round) {
+        std::vector<ustring> pats(1 + rng() % 12);
+        for (auto &p : pats)
+            p = search_text(rng, rng() % 8);
+        multi_matcher matcher(pats);
+        auto hay = search_text(rng, rng() % 2000);
+
+        std::vector<std::pair<size_t, qword>> expect;
+        for (size_t id = 0; id < pats.size(); ++id) {
+            auto &p = pats[id];
+            if (p.empty())
+                continue;
+            for (size_t i = 0; i + p.size() <= hay.size(); ++i) {
+                if (std::equal(p.begin(), p.end(), hay.begin() + i))
+                    expect.emplace_back(id, i + p.size());
+            }
+        }
+        std::sort(expect.begin(), expect.end());
+
+        std::vector<std::pair<size_t, qword>> got;
+        auto collect = [&](size_t id, qword end) { got.emplace_back(id, end); };
+        matcher.scan(make_view(hay), collect);
+        std::sort(got.begin(), got.end());
+        SELFCHECK(got == expect, "scan round %zu: %zu matches != %zu", round, got.size(), expect.size());
+
+        got.clear();
+        matcher.scan_chain(search_split(hay, rng), collect);
+        std::sort(got.begin(), got.end());
+        SELFCHECK(got == expect, "scan_chain round %zu: %zu matches != %zu", round, got.size(), expect.size());
+
+        auto any = matcher.contains_any(make_view(hay));
+        SELFCHECK(any == !expect.empty(), "contains_any round %zu: %d", round, any);
+    }
+    std::printf("byte_search: %zu searches ok\n", searches);
+}
+
+/**
+ * \brief 对照 snprintf 检查一个指示符与参数
+ */
+template<class T>
+static void printf_compare(const std::string &fmt, T v, size_t &count) {
+    char expect[512];
+    std::snprintf(expect, sizeof(expect), fmt.c_str(), v);
+    auto &got = log_format::format(fmt.c_str(), v);
+    SELFCHECK(got == expect, "format '%s': '%s' != '%s'", fmt.c_str(), got.c_str(), expect);
+    ++count;
+}
+
+/**
+ * \brief 由 flags 子集、宽度与精度组合出的所有指示符
+ */
+static std::vector<std::string> printf_specs(const char *flags, const char *length, char conv,
+    const std::vector<std::string> &precisions) {
+    const char *widths[] = { "", "1", "7", "25" };
+    auto nflags = std::strlen(flags);
+    std::vector<std::string> out;
+    for (size_t mask = 0; mask < (size_t(1) << nflags); ++mask) {
+        std::string f;
+        for (size_t k = 0; k < nflags; ++k) {
+            if (mask & (size_t(1) << k))
+                f.push_back(flags[k]);
+        }
+        for (auto w : widths) {
+            for (auto &p : precisions)
+                out.push_back("<%" + f + w + p + length + conv + ">");
+        }
+    }
+    return out;
+}
+
+/**
+ * \brief operator<< 中再次格式化，检查嵌套调用不破坏外层结果
+ */
+struct nested_arg {
+    int value;
+};
+
+static std::ostream &operator<<(std::ostream &os, const nested_arg &a) {
+    return os << log_format::format("(%d:%s)", a.value, "in");
+}
+
+static void check_log_format() {
+    size_t count = 0;
+    const std::vector<std::string> int_prec = { "", ".", ".0", ".1", ".5", ".30" };
+    /*# 用于 d 与 +、空格用于无符号转换在 C 中无定义，不参与比较*/
+    const int ints[] = { 0, 1, -1, 42, -42, 123456789, std::numeric_limits<int>::max(), std::numeric_limits<int>::min() };
+    const long long longs[] = { 0, -9876543210123LL, std::numeric_limits<long long>::min(),
+        std::numeric_limits<long long>::max() };
+    const unsigned uints[] = { 0u, 1u, 8u, 255u, 0xDEADBEEFu, std::numeric_limits<unsigned>::max() };
+    const unsigned long long ulongs[] = { 0ull, 0x123456789ABCDEFull, std::numeric_limits<unsigned long long>::max() };
+    for (auto conv : { 'd', 'i' }) {
+        for (auto &spec : printf_specs("-+ 0", "", conv, int_prec)) {
+            for (auto v : ints)
+                printf_compare(spec, v, count);
+        }
+        for (auto &spec : printf_specs("-+ 0", "ll", conv, int_prec)) {
+            for (auto v : longs)
+                printf_compare(spec, v, count);
+        }
+    }
+    for (auto conv : { 'u', 'x', 'X', 'o' }) {
+        for (auto &spec : printf_specs(conv == 'u' ? "-0" : "-#0", "", conv, int_prec)) {
+            for (auto v : uints)
+                printf_compare(spec, v, count);
+        }
+        for (auto &spec : printf_specs(conv == 'u' ? "-0" : "-#0", "ll", conv, int_prec)) {
+            for (auto v : ulongs)
+                printf_compare(spec, v, count);
+        }
+    }
+
+    const double doubles[] = { 0.0, -0.0, 0.5, 1.5, 2.5, -3.75, 1e-7, 0.125, 123456.789, 9.9999999, 1e20, -1e300,
+        std::numeric_limits<double>::infinity() };
+    const std::vector<std::string> float_prec = { "", ".0", ".1", ".3", ".10" };
+    for (auto conv : { 'f', 'e', 'E', 'g', 'G' }) {
+        for (auto &spec : printf_specs("-+ #0", "", conv, float_prec)) {
+            for (auto v : doubles)
+                printf_compare(spec, v, count);
+        }
+    }
+
+    const char *strings[] = { "", "a", "hello world" };
+    for (auto &spec : printf_specs("-", "", 's', int_prec)) {
+        for (auto v : strings)
+            printf_compare(spec, v, count);
+    }
+    for (auto &spec : printf_specs("-", "", 'c', { "" })) {
+        for (auto v : { 'a', 'Z', ' ' })
+            printf_compare(spec, v, count);
+    }
+    int x = 0;
+    for (auto &spec : printf_specs("-", "", 'p', { "" }))
+        printf_compare(spec, static_cast<void *>(&x), count);
+
+    /*多个参数、%% 与 boost::format 风格的 %N%*/
+    auto &mixed = log_format::format("%s=%d%% %5.2f|%-4x|", "k", 7, 3.14159, 255u);
+    char expect[128];
+    std::snprintf(expect, sizeof(expect), "%s=%d%% %5.2f|%-4x|", "k", 7, 3.14159, 255u);
+    SELFCHECK(mixed == expect, "mixed: '%s' != '%s'", mixed.c_str(), expect);
+    auto &positional = log_format::format("%2% %1% %2%", "a", "b");
+    SELFCHECK(positional == "b a b", "positional: '%s'", positional.c_str());
+
+    /*参数的 operator<< 中嵌套格式化*/
+    auto &outer = log_format::format("[%s|%d|%s]", nested_arg{ 1 }, 5, nested_arg{ 2 });
+    SELFCHECK(outer == "[(1:in)|5|(2:in)]", "nested: '%s'", outer.c_str());
+    std::printf("log_format: %zu conversions ok\n", count);
+}
+
+static void check_expiring_cache(std::mt19937_64 &rng) {
+    /*LRU：单分片、不过期，对照链表实现的参考模型*/
+    {
+        expiring_cache_options opts;
+        opts.shards = 1;
+        opts.shard_capacity = 32;
+        opts.ttl = std::chrono::milliseconds(0);
+        expiring_cache<int, int> cache(opts);
+        std::list<std::pair<int, int>> model;
+        auto find = [&](int k) {
+            auto it = model.begin();
+            while (it != model.end() && it->first != k)
+                ++it;
+            return it;
+        };
+        auto touch = [&](int k, int v) {
+            auto it = find(k);
+            if (it != model.end())
+                model.erase(it);
+            model.emplace_front(k, v);
+            if (model.size() > opts.shard_capacity)
+                model.pop_back();
+        };
+        for (int step = 0; step < 20000; ++step) {
+            auto k = static_cast<int>(rng() % 64);
+            auto it = find(k);
+            auto hit = it != model.end();
+            switch (rng() % 4) {
+            case 0: {
+                int v = -1;
+                auto got = cache.get(k, v);
+                SELFCHECK(got == hit && (!hit || v == it->second), "step %d: get %d", step, k);
+                if (hit)
+                    touch(k, it->second);
+                break;
+            }
+            case 1:
+                cache.put(k, step);
+                touch(k, step);
+                break;
+            case 2:
+                SELFCHECK(cache.erase(k) == hit, "step %d: erase %d", step, k);
+                if (hit)
+                    model.erase(it);
+                break;
+            default: {
+                bool loaded = false;
+                auto v = cache.get_or_compute(k, [&] { loaded = true; return step; });
+                SELFCHECK(loaded == !hit && v == (hit ? it->second : step), "step %d: get_or_compute %d", step, k);
+                touch(k, v);
+                break;
+            }
+            }
+            SELFCHECK(cache.size() == model.size(), "step %d: size %zu != %zu", step, cache.size(), model.size());
+        }
+    }
+
+    /*TTL：读取时按未命中处理，purge_expired 删除未读取的过期条目，ttl 为0不过期*/
+    {
+        expiring_cache_options opts;
+        opts.tick = std::chrono::milliseconds(1);
+        expiring_cache<int, int> cache(opts);
+        cache.put(1, 10, std::chrono::milliseconds(100));
+        cache.put(2, 20, std::chrono::milliseconds(100));
+        cache.put(3, 30, std::chrono::milliseconds(0));
+        cache.put(4, 40, std::chrono::seconds(60));
+        int v = 0;
+        SELFCHECK(cache.get(1, v) && v == 10, "ttl: fresh entry missed");
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        SELFCHECK(!cache.get(1, v), "ttl: expired entry returned");
+        auto purged = cache.purge_expired();
+        SELFCHECK(purged == 1, "ttl: purged %zu", purged);
+        SELFCHECK(cache.size() == 2 && cache.get(3, v) && cache.get(4, v), "ttl: live entries lost");
+        SELFCHECK(cache.get_stats().expirations == 2, "ttl: %llu expirations",
+            static_cast<unsigned long long>(cache.get_stats().expirations));
+    }
+
+    /*单飞：并发未命中只加载一次，异常传给所有等待者且不写入*/
+    {
+        expiring_cache<int, int> cache;
+        const int threads = 8;
+        for (int round = 0; round < 2; ++round) {
+            auto fail = round == 1;
+            std::atomic<int> started{ 0 };
+            std::atomic<int> loads{ 0 };
+            std::atomic<int> errors{ 0 };
+            std::vector<int> results(threads, 0);
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t] {
+                    ++started;
+                    while (started < threads)
+                        std::this_thread::yield();
+                    try {
+                        results[t] = cache.get_or_compute(round, [&] {
+                            ++loads;
+                            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                            if (fail)
+                                throw std::runtime_error("load failed");
+                            return 99;
+                        });
+                    }
+                    catch (const std::runtime_error &) {
+                        ++errors;
+                    }
+                });
+            }
+            for (auto &w : workers)
+                w.join();
+            int v = 0;
+            if (fail) {
+                SELFCHECK(errors == threads && !cache.get(round, v), "single flight: %d of %d errors",
+                    errors.load(), threads);
+            }
+            else {
+                SELFCHECK(loads == 1, "single flight: %d loads", loads.load());
+                for (auto r : results)
+                    SELFCHECK(r == 99, "single flight: got %d", r);
+            }
+        }
+
+        /*加载函数对同一个键重入时抛出 logic_error，而不是等待自己*/
+        bool reentered = false;
+        try {
+            cache.get_or_compute(7, [&] { return cache.get_or_compute(7, [] { return 1; }); });
+        }
+        catch (const std::logic_error &) {
+            reentered = true;
+        }
+        int v = 0;
+        SELFCHECK(reentered && !cache.get(7, v), "single flight: re-entry not detected");
+
+        /*加载期间的 put 优先，加载结果只返回不写入*/
+        std::atomic<bool> loading{ false };
+        std::atomic<bool> release{ false };
+        int loaded = 0;
+        std::thread loader([&] {
+            loaded = cache.get_or_compute(8, [&] {
+                loading = true;
+                while (!release)
+                    std::this_thread::yield();
+                return 100;
+            });
+        });
+        while (!loading)
+            std::this_thread::yield();
+        cache.put(8, 200);
+        release = true;
+        loader.join();
+        SELFCHECK(loaded == 100 && cache.get(8, v) && v == 200, "single flight: put during load lost, got %d", v);
+    }
+    std::printf("expiring_cache ok\n");
+}
+
+/**
+ * \brief 按大端逐字节写出数组的参考实现
+ */
+template<class T>
+static ustring big_endian_ref(const std::vector<T> &in) {
+    ustring out;
+    for (auto v : in) {
+        for (size_t i = sizeof(T); i-- > 0;)
+            out.push_back(static_cast<uchar>(static_cast<qword>(v) >> (8 * i)));
+    }
+    return out;
+}
+
+template<class T>
+static void check_big_endian(std::mt19937_64 &rng) {
+    for (size_t round = 0; round < 200; ++round) {
+        std::vector<T> values(rng() % 100);
+        for (auto &v : values)
+            v = static_cast<T>(rng());
+        ustring out;
+        byte_ops::append_be(out, values.data(), values.size());
+        SELFCHECK(out == big_endian_ref(values), "append_be %zu x %zu bytes", values.size(), sizeof(T));
+        std::vector<T> back(values.size());
+        byte_ops::read_be(out.data(), back.data(), back.size());
+        SELFCHECK(back == values, "read_be %zu x %zu bytes", values.size(), sizeof(T));
+        byte_ops::big_endian_inplace(back.data(), back.size());
+        byte_ops::big_endian_inplace(back.data(), back.size());
+        SELFCHECK(back == values, "big_endian_inplace twice %zu x %zu bytes", values.size(), sizeof(T));
+    }
+}
+
+static void check_byte_ops(std::mt19937_64 &rng) {
+    std::vector<uchar> src(512 + 16), dst(512 + 16);
+    for (size_t round = 0; round < 5000; ++round) {
+        /*长度、密钥长度、相位与起始对齐都随机，覆盖 SIMD 主体与标量尾部*/
+        auto n = static_cast<size_t>(rng() % 512);
+        auto klen = static_cast<size_t>(rng() % 40);
+        auto phase = static_cast<size_t>(rng() % 64);
+        auto in = src.data() + rng() % 16;
+        auto out = dst.data() + rng() % 16;
+        ustring key(klen);
+        for (auto &c : key)
+            c = static_cast<uchar>(rng());
+        for (size_t i = 0; i < n; ++i)
+            in[i] = static_cast<uchar>(rng());
+        auto next = byte_ops::xor_mask(in, out, n, make_view(key), phase);
+        auto ok = next == (klen ? (phase + n) % klen : 0);
+        for (size_t i = 0; i < n && ok; ++i)
+            ok = out[i] == static_cast<uchar>(in[i] ^ (klen ? key[(phase + i) % klen] : 0));
+        SELFCHECK(ok, "xor_mask n %zu key %zu phase %zu", n, klen, phase);
+
+        /*分两段就地处理，后一段接上前一段返回的相位*/
+        ustring s(in, n);
+        auto cut = n ? static_cast<size_t>(rng() % (n + 1)) : 0;
+        auto p = &s[0];
+        auto mid = byte_ops::xor_mask(p, p, cut, make_view(key), phase);
+        byte_ops::xor_mask(p + cut, p + cut, n - cut, make_view(key), mid);
+        SELFCHECK(std::memcmp(s.data(), out, n) == 0, "xor_mask in place n %zu split %zu", n, cut);
+
+        /*常量时间比较与 memcmp 一致*/
+        auto a = ustring_view(in, n);
+        SELFCHECK(byte_ops::equal_ct(a, ustring_view(s.data(), 0)) == (n == 0), "equal_ct length");
+        ustring b(in, n);
+        SELFCHECK(byte_ops::equal_ct(a, make_view(b)), "equal_ct n %zu", n);
+        if (n) {
+            b[rng() % n] ^= static_cast<uchar>(1 + rng() % 255);
+            SELFCHECK(!byte_ops::equal_ct(a, make_view(b)), "equal_ct n %zu missed a difference", n);
+        }
+    }
+    check_big_endian<ushort>(rng);
+    check_big_endian<uint>(rng);
+    check_big_endian<qword>(rng);
+    std::printf("byte_ops ok\n");
+}
+
+/**
+ * \brief 用 snprintf 逐行生成 xxd 格式的参考转储
+ */
+static std::string hexdump_ref(const uchar *p, size_t n, qword base, bool upper) {
+    std::string out;
+    char cell[16];
+    for (size_t off = 0; off < n; off += 16) {
+        std::snprintf(cell, sizeof(cell), upper ? "%08llX: " : "%08llx: ",
+            static_cast<unsigned long long>((base + off) & 0xFFFFFFFFu));
+        out += cell;
+        for (size_t i = 0; i < 16; ++i) {
+            if (off + i < n) {
+                std::snprintf(cell, sizeof(cell), upper ? "%02X" : "%02x", p[off + i]);
+                out += cell;
+            }
+            else {
+                out += "  ";
+            }
+            if (i & 1)
+                out += ' ';
+        }
+        out += ' ';
+        for (size_t i = off; i < n && i < off + 16; ++i)
+            out += p[i] >= 0x20 && p[i] < 0x7F ? static_cast<char>(p[i]) : '.';
+        out += '\n';
+    }
+    return out;
+}
+
+static void check_hexdump(std::mt19937_64 &rng) {
+    std::vector<uchar> buf(3000);
+    for (auto &c : buf)
+        c = static_cast<uchar>(rng() % 2 ? 0x20 + rng() % 0x60 : rng());
+    for (size_t round = 0; round < 500; ++round) {
+        auto n = static_cast<size_t>(rng() % buf.size());
+        hexdump_options opts;
+        opts.base_offset = rng() % 2 ? 0 : rng();
+        opts.upper = rng() % 2 == 0;
+        auto data = ustring_view(buf.data(), n);
+        auto expect = hexdump_ref(buf.data(), n, opts.base_offset, opts.upper);
+
+        std::ostringstream os;
+        hexdump_writer::write(os, data, opts);
+        SELFCHECK(os.str() == expect, "hexdump len %zu offset %llu", n, static_cast<unsigned long long>(opts.base_offset));
+
+        /*定长缓冲：截断为完整输出的前缀，总以 '\0' 结尾*/
+        char fixed[700];
+        auto cap = static_cast<size_t>(1 + rng() % sizeof(fixed));
+        auto len = hexdump_writer::write(fixed, cap, data, opts);
+        SELFCHECK(len == std::min(cap - 1, expect.size()) && fixed[len] == 0 && expect.compare(0, len, fixed) == 0,
+            "hexdump fixed buffer %zu len %zu", cap, n);
+
+        /*限制字节数：首尾各是完整输出的前缀与后缀，省略数与保留的字节数之和为总长*/
+        opts.max_bytes = static_cast<size_t>(1 + rng() % 200);
+        std::ostringstream capped;
+        hexdump_writer::write(capped, data, opts);
+        auto text = capped.str();
+        auto mark = text.find("... ");
+        if (mark == std::string::npos) {
+            SELFCHECK(text == expect, "hexdump max %zu len %zu: output differs without omission", opts.max_bytes, n);
+            continue;
+        }
+        auto eol = text.find('\n', mark);
+        auto omitted = std::strtoull(text.c_str() + mark + 4, nullptr, 10);
+        auto head = text.substr(0, mark);
+        auto tail = text.substr(eol + 1);
+        SELFCHECK(expect.compare(0, head.size(), head) == 0, "hexdump max %zu len %zu: head differs", opts.max_bytes, n);
+        SELFCHECK(tail.size() <= expect.size() && expect.compare(expect.size() - tail.size(), tail.size(), tail) == 0,
+            "hexdump max %zu len %zu: tail differs", opts.max_bytes, n);
+        size_t head_lines = std::count(head.begin(), head.end(), '\n');
+        size_t tail_lines = std::count(tail.begin(), tail.end(), '\n');
+        size_t total_lines = (n + 15) / 16;
+        SELFCHECK(head_lines + tail_lines < total_lines && omitted == (total_lines - head_lines - tail_lines) * 16,
+            "hexdump max %zu len %zu: %llu omitted", opts.max_bytes, n, omitted);
+        SELFCHECK(head_lines * 16 >= opts.max_bytes / 2 && tail_lines * 16 >= opts.max_bytes / 2,
+            "hexdump max %zu len %zu: kept %zu + %zu lines", opts.max_bytes, n, head_lines, tail_lines);
+    }
+    std::printf("hexdump ok\n");
+}
+
+static void check_byte_ring(std::mt19937_64 &rng) {
+    for (auto mirrored : { true, false }) {
+        byte_ring ring(5000, mirrored);
+        auto cap = ring.capacity();
+        ring.set_watermarks(cap / 4, cap * 3 / 4);
+        std::deque<uchar> model;
+        auto paused = false;
+        uchar next = 0;
+        for (size_t step = 0; step < 20000; ++step) {
+            if (rng() % 2) {
+                /*write 或 prepare/commit 部分写入*/
+                auto want = static_cast<size_t>(rng() % 1500);
+                ustring chunk(want);
+                for (auto &c : chunk)
+                    c = next++;
+                size_t n;
+                if (rng() % 2) {
+                    n = ring.write(make_view(chunk));
+                }
+                else {
+                    auto buf = ring.prepare(want);
+                    n = std::min(want, boost::asio::buffer_size(buf));
+                    std::memcpy(boost::asio::buffer_cast<uchar *>(buf), chunk.data(), n);
+                    ring.commit(n);
+                }
+                SELFCHECK(n == std::min(want, cap - model.size()), "ring %d step %zu: wrote %zu of %zu", mirrored, step,
+                    n, want);
+                model.insert(model.end(), chunk.begin(), chunk.begin() + n);
+                next = static_cast<uchar>(next - (want - n));
+                if (model.size() >= cap * 3 / 4)
+                    paused = true;
+            }
+            else {
+                auto n = static_cast<size_t>(rng() % 2000);
+                ring.consume(n);
+                model.erase(model.begin(), model.begin() + std::min(n, model.size()));
+                if (model.size() <= cap / 4)
+                    paused = false;
+            }
+            auto view = ring.data();
+            SELFCHECK(view.size() == model.size() && std::equal(model.begin(), model.end(), view.data()),
+                "ring %d step %zu: contents differ", mirrored, step);
+            SELFCHECK(ring.free_space() == cap - model.size(), "ring %d step %zu: free space", mirrored, step);
+            SELFCHECK(ring.read_paused() == paused, "ring %d step %zu: paused %d", mirrored, step, ring.read_paused());
+        }
+        if (!mirrored)
+            SELFCHECK(ring.compaction_count() > 0, "ring flat: never compacted");
+    }
+    std::printf("byte_ring ok\n");
+}
+
+static void check_shared_ustring(std::mt19937_64 &rng) {
+    ustring src(1000);
+    for (auto &c : src)
+        c = static_cast<uchar>(rng());
+    shared_ustring whole(src);
+    SELFCHECK(whole.unique() && whole.to_ustring() == src, "shared_ustring: construct");
+
+    /*切片对照 substr，共享同一块内存，引用计数随之增减*/
+    std::vector<std::pair<shared_ustring, ustring>> slices;
+    for (size_t i = 0; i < 200; ++i) {
+        auto k = slices.empty() || rng() % 2 ? slices.size() : static_cast<size_t>(rng() % slices.size());
+        auto &base = k == slices.size() ? whole : slices[k].first;
+        auto &model = k == slices.size() ? src : slices[k].second;
+        auto off = static_cast<size_t>(rng() % (base.size() + 1));
+        auto len = rng() % 4 == 0 ? shared_ustring::npos : static_cast<size_t>(rng() % (base.size() + 10));
+        ustring expect(model.data() + off, std::min(len, model.size() - off));
+        auto s = base.slice(off, len);
+        SELFCHECK(s.to_ustring() == expect && (s.empty() || s.data() == base.data() + off),
+            "shared_ustring: slice %zu,%zu of %zu", off, len, base.size());
+        slices.emplace_back(std::move(s), std::move(expect));
+    }
+    SELFCHECK(whole.use_count() == slices.size() + 1, "shared_ustring: use_count %zu with %zu slices",
+        whole.use_count(), slices.size());
+    bool thrown = false;
+    try {
+        whole.slice(whole.size() + 1);
+    }
+    catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    SELFCHECK(thrown, "shared_ustring: slice past the end did not throw");
+
+    /*写时复制：修改一个切片不影响共享者，独占后不再复制*/
+    auto &victim = slices[rng() % slices.size()];
+    if (!victim.first.empty()) {
+        auto before = whole.use_count();
+        victim.first.mutable_data()[0] ^= 0xFF;
+        victim.second[0] ^= 0xFF;
+        SELFCHECK(victim.first.unique() && whole.use_count() == before - 1 && whole.to_ustring() == src,
+            "shared_ustring: copy on write leaked");
+        auto p = victim.first.data();
+        SELFCHECK(victim.first.mutable_data() == p, "shared_ustring: unique copy was copied again");
+    }
+    for (auto &s : slices)
+        SELFCHECK(s.first.to_ustring() == s.second, "shared_ustring: slice content changed");
+    SELFCHECK(whole.to_hexstring(" ", false) == src.to_hexstring(" ", false), "shared_ustring: to_hexstring");
+
+    /*多个线程同时复制与释放，结束后计数回到原值*/
+    slices.clear();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&whole] {
+            for (int i = 0; i < 20000; ++i) {
+                shared_ustring a(whole);
+                auto b = a.slice(static_cast<size_t>(i) % a.size(), 8);
+                shared_ustring c(std::move(b));
+                (void)c;
+            }
+        });
+    }
+    for (auto &w : workers)
+        w.join();
+    SELFCHECK(whole.unique(), "shared_ustring: use_count %zu after threads", whole.use_count());
+    std::printf("shared_ustring ok\n");
+}
+
+static void check_parallel_ops(std::mt19937_64 &rng) {
+    boost::threadpool::fifo_pool pool(4);
+    for (size_t round = 0; round < 60; ++round) {
+        /*阈值与块都很小，使跨块边界的匹配与末尾的短块都经常出现*/
+        parallel_options opts;
+        opts.min_parallel = 512;
+        opts.chunk_size = static_cast<size_t>(1 + rng() % 3000);
+        parallel_ops<> ops(pool, opts);
+        auto data = search_text(rng, rng() % 40000);
+        auto pat = search_text(rng, 1 + rng() % 6);
+        auto view = make_view(data);
+
+        SELFCHECK(ops.to_hexstring(view, ":", false) == data.to_hexstring(":", false),
+            "parallel to_hexstring len %zu chunk %zu", data.size(), opts.chunk_size);
+        auto crc = ops.crc32c_of(view);
+        auto expect_crc = crc32c::compute(view);
+        SELFCHECK(crc == expect_crc, "parallel crc32c len %zu chunk %zu: %08x != %08x", data.size(), opts.chunk_size,
+            crc, expect_crc);
+
+        auto first = ops.find(view, make_view(pat));
+        auto expect_first = search_ref(data, pat, 0);
+        SELFCHECK(first == expect_first, "parallel find len %zu chunk %zu pat %zu: %zu != %zu", data.size(),
+            opts.chunk_size, pat.size(), first, expect_first);
+        std::vector<size_t> expect_all;
+        for (auto pos = search_ref(data, pat, 0); pos != byte_searcher::npos; pos = search_ref(data, pat, pos + 1))
+            expect_all.push_back(pos);
+        auto all = ops.find_all(view, make_view(pat));
+        SELFCHECK(all == expect_all, "parallel find_all len %zu chunk %zu pat %zu: %zu != %zu hits", data.size(),
+            opts.chunk_size, pat.size(), all.size(), expect_all.size());
+    }
+    std::printf("parallel_ops ok\n");
+}
+
+static void check_buffer_pool(std::mt19937_64 &rng) {
+    auto &pool = buffer_pool::instance();
+    /*级别：不小于请求的最小 2 的幂，超过最大级别不入池*/
+    for (size_t n = 0; n <= buffer_pool::max_block + 1; n += 1 + rng() % 97) {
+        auto c = buffer_pool::class_of(n);
+        if (n > buffer_pool::max_block) {
+            SELFCHECK(c == buffer_pool::class_count, "class_of(%zu) = %zu", n, c);
+            continue;
+        }
+        auto size = buffer_pool::class_size(c);
+        SELFCHECK(c < buffer_pool::class_count && size >= n && (c == 0 || buffer_pool::class_size(c - 1) < n),
+            "class_of(%zu) = %zu", n, c);
+    }
+
+    /*归还后同级别的分配复用本线程缓存中的块*/
+    pool.trim();
+    auto p = pool.allocate(1000);
+    pool.deallocate(p, 1000);
+    auto before = pool.get_stats();
+    auto q = pool.allocate(900);
+    auto after = pool.get_stats();
+    SELFCHECK(q == p && after.hits == before.hits + 1, "buffer_pool: freed block not reused");
+    pool.deallocate(q, 900);
+
+    /*多个线程分配、写入、交叉归还，内容不被其他线程覆盖*/
+    std::vector<std::thread> workers;
+    std::atomic<int> corrupted{ 0 };
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&pool, &corrupted, t] {
+            std::mt19937_64 local(static_cast<qword>(t));
+            std::vector<std::pair<uchar *, size_t>> live;
+            for (int i = 0; i < 20000; ++i) {
+                if (live.size() < 64 && local() % 2) {
+                    auto n = static_cast<size_t>(1 + local() % (buffer_pool::max_block + 4096));
+                    auto b = static_cast<uchar *>(pool.allocate(n));
+                    std::memset(b, t, n);
+                    live.emplace_back(b, n);
+                }
+                else if (!live.empty()) {
+                    auto k = static_cast<size_t>(local() % live.size());
+                    auto b = live[k];
+                    if (std::count(b.first, b.first + b.second, static_cast<uchar>(t)) != static_cast<std::ptrdiff_t>(b.second))
+                        ++corrupted;
+                    pool.deallocate(b.first, b.second);
+                    live[k] = live.back();
+                    live.pop_back();
+                }
+            }
+            for (auto &b : live)
+                pool.deallocate(b.first, b.second);
+        });
+    }
+    for (auto &w : workers)
+        w.join();
+    SELFCHECK(corrupted == 0, "buffer_pool: %d blocks overwritten", corrupted.load());
+
+    /*trim 立即释放全局仓库，本线程缓存在下次访问时释放*/
+    auto retained = pool.get_stats().bytes_retained;
+    pool.trim();
+    auto cached = pool.get_stats().bytes_retained;
+    SELFCHECK(cached <= retained, "buffer_pool: trim grew the pool");
+    pool.deallocate(pool.allocate(64), 64);
+    cached = pool.get_stats().bytes_retained;
+    SELFCHECK(cached == buffer_pool::min_block, "buffer_pool: %llu bytes retained after trim",
+        static_cast<unsigned long long>(cached));
+
+    /*使用池分配器的字节串与普通字节串内容一致*/
+    for (size_t i = 0; i < 200; ++i) {
+        auto n = static_cast<size_t>(rng() % 100000);
+        pooled_ustring a;
+        ustring b;
+        for (size_t k = 0; k < n; k += 1 + k / 3) {
+            auto c = static_cast<uchar>(rng());
+            a.push_back(c);
+            b.push_back(c);
+        }
+        SELFCHECK(a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size()) == 0, "pooled_ustring len %zu",
+            b.size());
+    }
+    std::printf("buffer_pool ok\n");
+}
+
+static void check_mapped_file(std::mt19937_64 &rng) {
+    /*在当前目录写一个不足整页的临时文件*/
+    const std::string path = "selfcheck_mapped.bin";
+    ustring content(300000 + rng() % 4096);
+    for (auto &c : content)
+        c = static_cast<uchar>(rng());
+    auto fp = std::fopen(path.c_str(), "wb");
+    SELFCHECK(fp && std::fwrite(content.data(), 1, content.size(), fp) == content.size(), "mapped_file: write %s",
+        path.c_str());
+    if (fp)
+        std::fclose(fp);
+
+    ERRCODE ec;
+    mapped_file whole;
+    SELFCHECK(whole.open(path, ec) && make_view(content) == whole.view(), "mapped_file: whole file, %s",
+        ec.message().c_str());
+
+    /*任意偏移与长度，包括未对齐的起点与超出文件末尾的长度*/
+    for (size_t i = 0; i < 100; ++i) {
+        auto offset = static_cast<qword>(rng() % (content.size() + 1));
+        auto length = static_cast<size_t>(rng() % 8 == 0 ? 0 : rng() % 100000);
+        auto expect = length == 0 ? content.size() - offset : std::min<size_t>(length, content.size() - offset);
+        mapped_file part;
+        auto ok = part.open(path, ec, mapped_file_options(), offset, length);
+        SELFCHECK(ok && part.view() == ustring_view(content.data() + offset, expect),
+            "mapped_file: offset %llu length %zu, %s", static_cast<unsigned long long>(offset), length,
+            ec.message().c_str());
+    }
+    mapped_file past;
+    SELFCHECK(!past.open(path, ec, mapped_file_options(), content.size() + 1) &&
+        ec == boost::system::errc::invalid_argument, "mapped_file: offset past the end");
+
+    /*逐段映射拼接回原文件，偏移连续*/
+    auto chunk_size = static_cast<size_t>(1 + rng() % 70000);
+    ustring joined;
+    auto ok = mapped_file::for_each_chunk(path, chunk_size, [&](ustring_view chunk, qword offset) {
+        SELFCHECK(offset == joined.size(), "mapped_file: chunk at %llu", static_cast<unsigned long long>(offset));
+        joined.append(chunk.data(), chunk.size());
+        return true;
+    }, ec);
+    SELFCHECK(ok && joined == content, "mapped_file: for_each_chunk %zu, %s", chunk_size, ec.message().c_str());
+
+    /*空文件得到空视图，不存在的文件报错*/
+    fp = std::fopen(path.c_str(), "wb");
+    if (fp)
+        std::fclose(fp);
+    mapped_file empty;
+    SELFCHECK(empty.open(path, ec) && empty.size() == 0, "mapped_file: empty file, %s", ec.message().c_str());
+    std::remove(path.c_str());
+    mapped_file missing;
+    SELFCHECK(!missing.open(path, ec) && ec, "mapped_file: missing file opened");
+    std::printf("mapped_file ok\n");
+}
+
+static void check_timer_stats(std::mt19937_64 &rng) {
+    /*桶：0 单独一桶，其余为不大于值的最高位加一，超出的并入最后一桶*/
+    for (size_t i = 0; i < 100000; ++i) {
+        auto ns = i < 200 ? static_cast<qword>(i) : rng() >> (rng() % 64);
+        uint expect = 0;
+        while (expect < log2_histogram::buckets - 1 && log2_histogram_snapshot::upper_bound(expect) <= ns)
+            ++expect;
+        auto got = log2_histogram::bucket_of(ns);
+        SELFCHECK(got == expect, "bucket_of(%llu) = %u, expect %u", static_cast<unsigned long long>(ns), got, expect);
+    }
+
+    /*并发记录不丢样本，分位数等于排序后对应样本所在桶的上界*/
+    log2_histogram hist;
+    std::vector<std::vector<qword>> samples(4);
+    for (auto &v : samples) {
+        v.resize(50000);
+        for (auto &x : v)
+            x = rng() % 3 == 0 ? 0 : rng() >> (16 + rng() % 48);
+    }
+    std::vector<std::thread> workers;
+    for (auto &v : samples) {
+        workers.emplace_back([&hist, &v] {
+            for (auto x : v)
+                hist.record(x);
+        });
+    }
+    for (auto &w : workers)
+        w.join();
+    std::vector<qword> all;
+    for (auto &v : samples)
+        all.insert(all.end(), v.begin(), v.end());
+    std::sort(all.begin(), all.end());
+    auto snap = hist.snapshot();
+    SELFCHECK(snap.total() == all.size(), "histogram: %llu of %zu samples", static_cast<unsigned long long>(snap.total()),
+        all.size());
+    for (auto q : { 0.0, 0.1, 0.5, 0.9, 0.99, 0.999, 1.0 }) {
+        auto rank = std::min(all.size() - 1, static_cast<size_t>(q * static_cast<double>(all.size())));
+        auto expect = log2_histogram_snapshot::upper_bound(log2_histogram::bucket_of(all[rank]));
+        auto got = snap.percentile(q);
+        SELFCHECK(got == expect, "percentile(%g) = %llu, expect %llu", q, static_cast<unsigned long long>(got),
+            static_cast<unsigned long long>(expect));
+    }
+    hist.record(std::chrono::microseconds(3));
+    hist.record(std::chrono::nanoseconds(-5));
+    auto after = hist.snapshot();
+    SELFCHECK(after.counts[log2_histogram::bucket_of(3000)] == snap.counts[log2_histogram::bucket_of(3000)] + 1 &&
+        after.counts[0] == snap.counts[0] + 1, "histogram: duration overload");
+    SELFCHECK(log2_histogram_snapshot().percentile(0.5) == 0, "histogram: empty percentile");
+    std::printf("timer_stats ok\n");
+}
+
+/**
+ * \brief 在独立线程上运行的 io_service，定时器析构前先 stop()
+ */
+struct io_thread {
+    boost::asio::io_service             io;
+    boost::asio::io_service::work       work{ io };
+    std::thread                         thread{ [this] { io.run(); } };
+
+    void stop() {
+        io.stop();
+        if (thread.joinable())
+            thread.join();
+    }
+
+    ~io_thread() { stop(); }
+};
+
+/**
+ * \brief 周期任务落在以加入时间为起点的网格上：不早于网格触发，长时间运行也不累积漂移
+ */
+template<class _Timer>
+static void check_timer_grid(const char *name, _Timer &timer) {
+    using clock = std::chrono::steady_clock;
+    const auto period = std::chrono::milliseconds(20);
+    const size_t periods = 20;
+    std::mutex mu;
+    std::vector<clock::time_point> fired;
+    auto start = clock::now();
+    auto h = timer.add_doing(period, [&] {
+        std::lock_guard<std::mutex> lock(mu);
+        fired.push_back(clock::now());
+    });
+    std::this_thread::sleep_for(period * periods + period / 2);
+    h.cancel();
+
+    std::lock_guard<std::mutex> lock(mu);
+    SELFCHECK(fired.size() >= periods / 2 && fired.size() <= periods, "%s: %zu fires in %zu periods", name,
+        fired.size(), periods);
+    for (size_t k = 0; k < fired.size(); ++k) {
+        /*追赶策略为 skip，迟到后跳过的周期不补，第 k 次不早于第 k+1 个网格点*/
+        SELFCHECK(fired[k] >= start + period * (k + 1), "%s: fire %zu early by %lld us", name, k,
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(
+                start + period * (k + 1) - fired[k]).count()));
+    }
+    /*按上一次触发时间重新计时会逐次漂移，相对网格的偏移散布到整个周期；不漂移时绝大多数落在前半周期*/
+    size_t on_grid = 0;
+    for (auto t : fired) {
+        auto since = t - start;
+        if (since - period * (since / period) < period / 2)
+            ++on_grid;
+    }
+    SELFCHECK(on_grid * 4 >= fired.size() * 3, "%s: only %zu of %zu fires near the grid", name, on_grid, fired.size());
+}
+
+/**
+ * \brief 任务句柄：取消后不再触发，reset 改周期或推迟，del_doing 删除同周期的任务
+ */
+template<class _Timer>
+static void check_timer_handles(const char *name, _Timer &timer) {
+    using std::chrono::milliseconds;
+    std::atomic<int> fast{ 0 };
+    auto h = timer.add_doing(milliseconds(5), [&] { ++fast; });
+    std::this_thread::sleep_for(milliseconds(60));
+    SELFCHECK(h.active() && h.cancel(), "%s: cancel of a running task", name);
+    /*取消时可能有一次回调正在执行*/
+    std::this_thread::sleep_for(milliseconds(10));
+    auto seen = fast.load();
+    std::this_thread::sleep_for(milliseconds(50));
+    SELFCHECK(seen > 0 && fast == seen, "%s: %d fires before cancel, %d after", name, seen, fast.load());
+    SELFCHECK(!h.active() && !h.cancel() && !h.reset() && !h.reset(milliseconds(1)),
+        "%s: cancelled handle still usable", name);
+    SELFCHECK(h.fires() == static_cast<qword>(seen), "%s: handle fires %llu != %d", name,
+        static_cast<unsigned long long>(h.fires()), seen);
+
+    /*reset(period) 以新周期从现在重新计时*/
+    std::atomic<int> slow{ 0 };
+    auto r = timer.add_doing(std::chrono::seconds(10), [&] { ++slow; });
+    SELFCHECK(r.reset(milliseconds(5)), "%s: reset(period) failed", name);
+    std::this_thread::sleep_for(milliseconds(100));
+    SELFCHECK(slow >= 5, "%s: %d fires after reset to 5 ms", name, slow.load());
+    r.cancel();
+
+    /*reset() 不断推迟空闲超时，停止推迟后才触发*/
+    std::atomic<int> idle{ 0 };
+    auto t = timer.add_doing(milliseconds(80), [&] { ++idle; });
+    for (int i = 0; i < 10; ++i) {
+        std::this_thread::sleep_for(milliseconds(20));
+        t.reset();
+    }
+    SELFCHECK(idle == 0, "%s: idle timeout fired %d times while postponed", name, idle.load());
+    std::this_thread::sleep_for(milliseconds(200));
+    SELFCHECK(idle >= 1, "%s: idle timeout never fired", name);
+    t.cancel();
+
+    /*del_doing 删除该周期的全部任务*/
+    auto a = timer.add_doing(milliseconds(7), [] {});
+    auto b = timer.add_doing(milliseconds(7), [] {});
+    auto c = timer.add_doing(milliseconds(9), [] {});
+    timer.del_doing(milliseconds(7));
+    SELFCHECK(!a.active() && !b.active() && c.active(), "%s: del_doing", name);
+    c.cancel();
+}
+
+/**
+ * \brief 回调在线程池上执行，比周期长的回调按 overrun 策略跳过或排队，同一任务从不并发
+ */
+static void check_timer_pool() {
+    using std::chrono::milliseconds;
+    boost::threadpool::fifo_pool pool(4);
+    for (auto guard : { timer_policy::overrun::skip, timer_policy::overrun::queue }) {
+        auto name = guard == timer_policy::overrun::skip ? "overrun skip" : "overrun queue";
+        io_thread runner;
+        forever_timer timer(runner.io);
+        timer.set_pool(pool);
+        std::atomic<int> running{ 0 };
+        std::atomic<int> overlapped{ 0 };
+        std::atomic<int> on_timer_thread{ 0 };
+        auto timer_thread = runner.thread.get_id();
+        auto h = timer.add_doing(milliseconds(10), [&] {
+            if (++running > 1)
+                ++overlapped;
+            if (std::this_thread::get_id() == timer_thread)
+                ++on_timer_thread;
+            std::this_thread::sleep_for(milliseconds(35));
+            --running;
+        }, timer_policy::catch_up::skip, guard);
+        std::this_thread::sleep_for(milliseconds(300));
+        h.cancel();
+        pool.wait();
+        SELFCHECK(overlapped == 0 && on_timer_thread == 0, "%s: %d overlapped, %d on the timer thread", name,
+            overlapped.load(), on_timer_thread.load());
+        SELFCHECK(h.fires() >= 3 && h.skipped() > 0, "%s: %llu fires, %llu skipped", name,
+            static_cast<unsigned long long>(h.fires()), static_cast<unsigned long long>(h.skipped()));
+        if (guard == timer_policy::overrun::queue)
+            SELFCHECK(timer.queued() > 0, "%s: nothing queued", name);
+        else
+            SELFCHECK(timer.queued() == 0, "%s: %llu queued", name, static_cast<unsigned long long>(timer.queued()));
+        runner.stop();
+    }
+}
+
+static void check_forever_timer() {
+    io_thread runner;
+    forever_timer timer(runner.io);
+    check_timer_grid("forever_timer", timer);
+    check_timer_handles("forever_timer", timer);
+    runner.stop();
+    check_timer_pool();
+    std::printf("forever_timer ok\n");
+}
+
+/**
+ * \brief 分片定时器：任务固定在一个分片线程上执行，外部线程加入的任务轮流分配，
+ * 在分片线程上加入的任务留在本分片，跨线程取消之后不再触发
+ */
+static void check_sharded_timer() {
+    using std::chrono::milliseconds;
+    io_thread runners[3];
+    std::vector<boost::asio::io_service *> services;
+    for (auto &r : runners)
+        services.push_back(&r.io);
+    {
+        sharded_timer timer(services);
+        check_timer_grid("sharded_timer", timer);
+
+        const size_t tasks = 6;
+        std::mutex mu;
+        std::vector<std::set<std::thread::id>> threads(tasks);
+        std::set<std::thread::id> child_threads;
+        std::thread::id parent_thread;
+        std::atomic<int> child_fires{ 0 };
+        sharded_timer::handle child;
+        std::vector<sharded_timer::handle> handles;
+        for (size_t i = 0; i < tasks; ++i) {
+            handles.push_back(timer.add_doing(milliseconds(5), [&, i] {
+                std::lock_guard<std::mutex> lock(mu);
+                threads[i].insert(std::this_thread::get_id());
+                if (i == 0 && !child) {
+                    parent_thread = std::this_thread::get_id();
+                    child = timer.add_doing(milliseconds(5), [&] {
+                        ++child_fires;
+                        std::lock_guard<std::mutex> lock(mu);
+                        child_threads.insert(std::this_thread::get_id());
+                    });
+                }
+            }));
+        }
+        std::this_thread::sleep_for(milliseconds(100));
+        for (auto &h : handles)
+            SELFCHECK(h.cancel(), "sharded_timer: cancel of a running task");
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            SELFCHECK(child.cancel(), "sharded_timer: cancel of the child task");
+        }
+        std::this_thread::sleep_for(milliseconds(20));
+        auto seen = child_fires.load();
+        std::this_thread::sleep_for(milliseconds(50));
+
+        for (auto &r : runners)
+            r.stop();
+        std::set<std::thread::id> used;
+        for (size_t i = 0; i < tasks; ++i) {
+            SELFCHECK(threads[i].size() == 1, "sharded_timer: task %zu ran on %zu threads", i, threads[i].size());
+            used.insert(threads[i].begin(), threads[i].end());
+        }
+        SELFCHECK(used.size() == services.size(), "sharded_timer: tasks spread over %zu of %zu shards", used.size(),
+            services.size());
+        SELFCHECK(child_threads.size() == 1 && *child_threads.begin() == parent_thread,
+            "sharded_timer: task added on a shard thread moved to another shard");
+        SELFCHECK(seen > 0 && child_fires == seen, "sharded_timer: %d fires before cancel, %d after", seen,
+            child_fires.load());
+    }
+    std::printf("sharded_timer ok\n");
+}
+
+/**
+ * \brief timerfd 驱动：与 asio 驱动行为一致，正常运行时没有错误
+ */
+static void check_timerfd_driver() {
+#ifdef __linux__
+    {
+        fd_forever_timer timer;
+        check_timer_grid("fd_forever_timer", timer);
+        check_timer_handles("fd_forever_timer", timer);
+        auto ec = timer.get_driver().failure();
+        SELFCHECK(!ec, "fd_forever_timer: driver failed, %s", ec.message().c_str());
+    }
+    std::printf("timerfd_driver ok\n");
+#endif
+}
+
+/**
+ * \brief 日志消息被求值的次数
+ */
+static int log_evaluations = 0;
+
+static int log_evaluated() { return ++log_evaluations; }
+
+static log_category selfcheck_log("selfcheck");
+
+/**
+ * \brief 关闭的等级不对消息求值：运行期按分类或全局等级，编译期按 BU_LOG_MIN_LEVEL
+ */
+static void check_log_levels() {
+    auto saved = log_category::default_level();
+    /*只检查是否求值，不产生输出*/
+    boost::log::core::get()->set_logging_enabled(false);
+
+    logger::set_level(loglevel::Log_Warning);
+    SELFCHECK(!LOG_ENABLED(Log_Info) && !LOG_ENABLED(Log_Debug) && LOG_ENABLED(Log_Warning) && LOG_ENABLED(Log_Fatal),
+        "log level: global gating");
+    LOG_INFO("evaluated " << log_evaluated());
+    LOG_DEBUG_F("evaluated %d", log_evaluated());
+    SELFCHECK(log_evaluations == 0, "log level: disabled site evaluated its message %d times", log_evaluations);
+
+    /*分类的等级优先于全局等级，reset_level 后恢复使用全局等级*/
+    SELFCHECK(logger::set_level("selfcheck", loglevel::Log_Info) && !logger::set_level("no such category",
+        loglevel::Log_Info), "log level: set_level by name");
+    SELFCHECK(log_category::find("selfcheck") == &selfcheck_log, "log level: find");
+#undef BU_LOG_CATEGORY
+#define BU_LOG_CATEGORY selfcheck_log
+    SELFCHECK(LOG_ENABLED(Log_Info), "log level: category override ignored");
+    selfcheck_log.reset_level();
+    SELFCHECK(!LOG_ENABLED(Log_Info), "log level: reset_level kept the override");
+#undef BU_LOG_CATEGORY
+#define BU_LOG_CATEGORY log_category::root()
+
+    /*编译期最低等级以下的调用点即使运行期等级允许也不求值*/
+    logger::set_level(loglevel::Log_Info);
+#undef BU_LOG_MIN_LEVEL
+#define BU_LOG_MIN_LEVEL 4
+    SELFCHECK(!LOG_ENABLED(Log_Warning) && LOG_ENABLED(Log_Error), "log level: compile-time gating");
+    LOG_WARNING("evaluated " << log_evaluated());
+    LOG_WARNING_F("evaluated %d", log_evaluated());
+    SELFCHECK(log_evaluations == 0, "log level: stripped site evaluated its message %d times", log_evaluations);
+#undef BU_LOG_MIN_LEVEL
+#define BU_LOG_MIN_LEVEL 0
+
+    logger::set_level(saved);
+    boost::log::core::get()->set_logging_enabled(true);
+    std::printf("log levels ok\n");
+}
+
+/**
+ * \brief 延迟格式化端到端：多个线程写入的同时 stop()，每条记录恰好输出一次，内容与同步格式化相同
+ */
+static void check_binlog() {
+    namespace sinks = boost::log::sinks;
+    auto stream = boost::make_shared<std::ostringstream>();
+    auto backend = boost::make_shared<sinks::text_ostream_backend>();
+    backend->add_stream(stream);
+    auto sink = boost::make_shared<sinks::synchronous_sink<sinks::text_ostream_backend>>(backend);
+    sink->set_formatter(boost::log::expressions::stream << boost::log::expressions::smessage);
+    boost::log::core::get()->add_sink(sink);
+
+    static const binlog_site site = { "t%d #%d %s %5.1f", loglevel::Log_Info, "selfcheck", __FILE__, __LINE__ };
+    const int threads = 4;
+    const int records = 20000;
+    binlog::instance().start();
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; ++t) {
+        writers.emplace_back([t] {
+            std::string text = "payload";
+            for (int i = 0; i < records; ++i)
+                binlog::write(site, t, i, text, i * 0.5);
+        });
+    }
+    /*写入进行中停止，之后的记录同步输出*/
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    binlog::instance().stop();
+    for (auto &w : writers)
+        w.join();
+    sink->flush();
+    boost::log::core::get()->remove_sink(sink);
+
+    std::vector<std::vector<int>> seen(threads, std::vector<int>(records, 0));
+    std::istringstream lines(stream->str());
+    std::string line;
+    size_t total = 0, malformed = 0;
+    while (std::getline(lines, line)) {
+        ++total;
+        int t = -1, i = -1;
+        if (std::sscanf(line.c_str(), "t%d #%d", &t, &i) != 2 || t < 0 || t >= threads || i < 0 || i >= records ||
+            line != log_format::format(site.fmt, t, i, "payload", i * 0.5)) {
+            ++malformed;
+            continue;
+        }
+        ++seen[t][i];
+    }
+    size_t missing = 0, repeated = 0;
+    for (auto &v : seen) {
+        for (auto n : v) {
+            missing += n == 0;
+            repeated += n > 1;
+        }
+    }
+    SELFCHECK(total == size_t(threads) * records && malformed == 0 && missing == 0 && repeated == 0,
+        "binlog: %zu lines, %zu malformed, %zu missing, %zu repeated", total, malformed, missing, repeated);
+    std::printf("binlog: %zu records ok\n", total);
+}
+
+int main(int argc, char **argv) {
+    auto seed = argc > 1 ? std::strtoull(argv[1], nullptr, 0) : 20261022ull;
+    std::printf("seed %llu\n", seed);
+    std::mt19937_64 rng(seed);
+
+    check_crc32c(rng);
+    check_base64(rng);
+    check_timing_wheel(rng);
+    check_binlog_codec();
+    check_log_levels();
+    check_binlog();
+    check_frame_decoder(rng);
+    check_byte_search(rng);
+    check_log_format();
+    check_expiring_cache(rng);
+    check_byte_ops(rng);
+    check_hexdump(rng);
+    check_byte_ring(rng);
+    check_shared_ustring(rng);
+    check_parallel_ops(rng);
+    check_buffer_pool(rng);
+    check_mapped_file(rng);
+    check_timer_stats(rng);
+    check_forever_timer();
+    check_sharded_timer();
+    check_timerfd_driver();
+
+    if (failures) {
+        std::printf("%zu checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,368 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月20日  18:20:44
+//  工程: boost-utils
+//  程序: ustring_bench
+//  文件: ustring_bench.cpp
+//  描述: ustring 常用操作的微基准测试
+// **************************************************************************/
+
+#include "../ustring.hxx"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * \brief 阻止编译器把结果当作无用代码优化掉
+ */
+template<class T>
+inline void keep(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    __asm__ volatile("" : : "r"(&value) : "memory");
+#else
+    static const void *volatile sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * \brief 运行参数
+ */
+struct bench_options {
+    /**
+     * \brief 预热轮数，不计入结果
+     */
+    size_t          warmup{ 5 };
+    /**
+     * \brief 采样轮数
+     */
+    size_t          reps{ 30 };
+    /**
+     * \brief 每轮最短时间（微秒），不足时加大每轮的执行次数
+     */
+    size_t          min_sample_us{ 2000 };
+    /**
+     * \brief 只运行名字包含该子串的用例
+     */
+    std::string     filter;
+    /**
+     * \brief 输出格式：text/csv/json
+     */
+    std::string     format{ "text" };
+};
+
+/**
+ * \brief 单个用例的统计结果，时间单位为纳秒每次
+ */
+struct bench_result {
+    std::string     name;
+    size_t          bytes{ 0 };
+    size_t          batch{ 0 };
+    size_t          samples{ 0 };
+    double          min{ 0 };
+    double          p50{ 0 };
+    double          p90{ 0 };
+    double          p99{ 0 };
+    double          max{ 0 };
+    double          mean{ 0 };
+
+    /**
+     * \brief 按中位数计算的吞吐量，bytes 为0时为0
+     */
+    double mb_per_sec() const {
+        return bytes && p50 > 0 ? bytes / p50 * 1e9 / (1024 * 1024) : 0;
+    }
+};
+
+/**
+ * \brief 基准测试执行器
+ *
+ * 每个用例先标定每轮执行次数，使一轮不短于 min_sample_us，再预热若干轮，
+ * 然后采样 reps 轮，每轮取平均单次耗时，对各轮结果求分位数。
+ */
+class bench_runner final {
+public:
+    using _Clock = std::chrono::steady_clock;
+
+    explicit bench_runner(const bench_options &opts) : options(opts) {}
+
+    /**
+     * \brief 运行用例，整轮计时
+     * \tparam _Func 用例类型，签名为 void()，每次调用为一次操作
+     * \param name 用例名
+     * \param bytes 每次操作处理的字节数，用于计算吞吐量，0 表示不计算
+     * \param f 用例
+     */
+    template<class _Func>
+    void run(const char *name, size_t bytes, _Func &&f) {
+        if (!selected(name))
+            return;
+        auto sample = [&](size_t batch) {
+            auto begin = _Clock::now();
+            for (size_t i = 0; i < batch; ++i)
+                f();
+            return std::chrono::duration<double, std::nano>(_Clock::now() - begin).count();
+        };
+        collect(name, bytes, sample);
+    }
+
+    /**
+     * \brief 运行需要准备数据的用例，准备部分不计时
+     * \tparam _Setup 准备类型，签名为 void()，每次操作前调用
+     * \tparam _Func 用例类型，签名为 void()
+     * \param name 用例名
+     * \param bytes 每次操作处理的字节数
+     * \param setup 准备
+     * \param f 用例
+     */
+    template<class _Setup, class _Func>
+    void run(const char *name, size_t bytes, _Setup &&setup, _Func &&f) {
+        if (!selected(name))
+            return;
+        auto sample = [&](size_t batch) {
+            double total = 0;
+            for (size_t i = 0; i < batch; ++i) {
+                setup();
+                auto begin = _Clock::now();
+                f();
+                total += std::chrono::duration<double, std::nano>(_Clock::now() - begin).count();
+            }
+            return total;
+        };
+        collect(name, bytes, sample);
+    }
+
+    /**
+     * \brief 输出全部结果
+     */
+    void report() const {
+        if (options.format == "csv") {
+            printf("name,bytes,batch,samples,min_ns,p50_ns,p90_ns,p99_ns,max_ns,mean_ns,mb_per_s\n");
+            for (auto &r : results)
+                printf("%s,%zu,%zu,%zu,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n", r.name.c_str(), r.bytes, r.batch,
+                    r.samples, r.min, r.p50, r.p90, r.p99, r.max, r.mean, r.mb_per_sec());
+        }
+        else if (options.format == "json") {
+            printf("[\n");
+            for (size_t i = 0; i < results.size(); ++i) {
+                auto &r = results[i];
+                printf("  {\"name\": \"%s\", \"bytes\": %zu, \"batch\": %zu, \"samples\": %zu, "
+                    "\"min_ns\": %.2f, \"p50_ns\": %.2f, \"p90_ns\": %.2f, \"p99_ns\": %.2f, "
+                    "\"max_ns\": %.2f, \"mean_ns\": %.2f, \"mb_per_s\": %.2f}%s\n",
+                    r.name.c_str(), r.bytes, r.batch, r.samples, r.min, r.p50, r.p90, r.p99, r.max, r.mean,
+                    r.mb_per_sec(), i + 1 < results.size() ? "," : "");
+            }
+            printf("]\n");
+        }
+        else {
+            printf("%-36s %12s %12s %12s %12s %12s\n", "name", "p50(ns)", "p90(ns)", "p99(ns)", "min(ns)", "MB/s");
+            for (auto &r : results) {
+                printf("%-36s %12.1f %12.1f %12.1f %12.1f ", r.name.c_str(), r.p50, r.p90, r.p99, r.min);
+                if (r.bytes)
+                    printf("%12.1f\n", r.mb_per_sec());
+                else
+                    printf("%12s\n", "-");
+            }
+        }
+    }
+
+private:
+
+    bool selected(const char *name) const {
+        return options.filter.empty() || strstr(name, options.filter.c_str()) != nullptr;
+    }
+
+    /**
+     * \brief 标定、预热、采样并统计
+     * \param sample 执行 batch 次并返回总耗时（纳秒）
+     */
+    template<class _Sample>
+    void collect(const char *name, size_t bytes, _Sample &&sample) {
+        const double min_ns = options.min_sample_us * 1000.0;
+        const size_t max_batch = size_t(1) << 30;
+        /*按本次耗时估算，最多放大到10倍*/
+        auto grow = [&](size_t batch, double ns) {
+            auto scale = ns > 0 ? min_ns / ns * 1.2 : 10.0;
+            return static_cast<size_t>(batch * std::min(std::max(scale, 2.0), 10.0));
+        };
+        auto calibrate = [&](size_t batch) {
+            for (;;) {
+                auto ns = sample(batch);
+                if (ns >= min_ns || batch >= max_batch)
+                    return batch;
+                batch = grow(batch, ns);
+            }
+        };
+
+        /*先预热再标定，避免冷启动的缺页与缓存未命中使第一次采样就达到 min_ns*/
+        for (size_t i = 0; i < options.warmup; ++i)
+            sample(1);
+        auto batch = calibrate(1);
+        for (size_t i = 0; i < options.warmup; ++i)
+            sample(batch);
+        /*预热后再确认一次，仍不足 min_ns 时继续放大*/
+        batch = calibrate(batch);
+
+        std::vector<double> per_op;
+        per_op.reserve(options.reps);
+        for (size_t i = 0; i < options.reps; ++i)
+            per_op.push_back(sample(batch) / batch);
+        std::sort(per_op.begin(), per_op.end());
+
+        bench_result r;
+        r.name = name;
+        r.bytes = bytes;
+        r.batch = batch;
+        r.samples = per_op.size();
+        if (!per_op.empty()) {
+            r.min = per_op.front();
+            r.max = per_op.back();
+            r.p50 = percentile(per_op, 0.50);
+            r.p90 = percentile(per_op, 0.90);
+            r.p99 = percentile(per_op, 0.99);
+            double sum = 0;
+            for (auto v : per_op)
+                sum += v;
+            r.mean = sum / per_op.size();
+        }
+        results.push_back(r);
+        if (options.format == "text")
+            fprintf(stderr, "done %s\n", name);
+    }
+
+    /**
+     * \brief 已排序数据的分位数，线性插值
+     */
+    static double percentile(const std::vector<double> &sorted, double q) {
+        auto pos = q * (sorted.size() - 1);
+        auto lo = static_cast<size_t>(pos);
+        auto hi = std::min(lo + 1, sorted.size() - 1);
+        return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - lo);
+    }
+
+    bench_options               options;
+    std::vector<bench_result>   results;
+};
+
+static void usage(const char *prog) {
+    printf("usage: %s [--reps N] [--warmup N] [--min-sample-us N] [--filter STR] [--format text|csv|json] [--quick]\n",
+        prog);
+}
+
+static bool parse_args(int argc, char **argv, bench_options &opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char * { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char *v = nullptr;
+        if (arg == "--quick") {
+            opts.warmup = 1;
+            opts.reps = 5;
+            opts.min_sample_us = 200;
+        }
+        else if (arg == "--reps" && (v = value()))
+            opts.reps = std::max<size_t>(1, strtoul(v, nullptr, 10));
+        else if (arg == "--warmup" && (v = value()))
+            opts.warmup = strtoul(v, nullptr, 10);
+        else if (arg == "--min-sample-us" && (v = value()))
+            opts.min_sample_us = strtoul(v, nullptr, 10);
+        else if (arg == "--filter" && (v = value()))
+            opts.filter = v;
+        else if (arg == "--format" && (v = value()) && (!strcmp(v, "text") || !strcmp(v, "csv") || !strcmp(v, "json")))
+            opts.format = v;
+        else
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    if (!parse_args(argc, argv, opts)) {
+        usage(argv[0]);
+        return 1;
+    }
+    bench_runner bench(opts);
+
+    const size_t small = 64;
+    const size_t page = 4096;
+    const size_t large = 1024 * 1024;
+    auto src_page = ustring::gen_random_ustring(page);
+    auto src_large = ustring::gen_random_ustring(large);
+    std::vector<uchar> vec_page(src_page.begin(), src_page.end());
+    auto hex_small = ustring::gen_random_ustring(small).to_hexstring(" ");
+    auto hex_page = src_page.to_hexstring();
+
+    /*构造*/
+    bench.run("construct/default", 0, [&] { ustring s; keep(s); });
+    bench.run("construct/zero_4k", page, [&] { ustring s(page); keep(s); });
+    bench.run("construct/ptr_4k", page, [&] { ustring s(src_page.data(), src_page.size()); keep(s); });
+    bench.run("construct/vector_4k", page, [&] { ustring s(vec_page); keep(s); });
+    bench.run("construct/hexstring_64", small, [&] { ustring s(hex_small); keep(s); });
+
+    /*追加*/
+    bench.run("append_int/x1024", 4 * 1024, [&] {
+        ustring s;
+        for (uint i = 0; i < 1024; ++i)
+            s.append_int(i);
+        keep(s);
+    });
+    bench.run("append_short/x1024", 2 * 1024, [&] {
+        ustring s;
+        for (ushort i = 0; i < 1024; ++i)
+            s.append_short(i);
+        keep(s);
+    });
+
+    /*从大缓冲头部弹出*/
+    ustring work;
+    bench.run("pop_int/1m_x256", 4 * 256, [&] { work = src_large; }, [&] {
+        uint sum = 0;
+        for (int i = 0; i < 256; ++i)
+            sum += work.pop_int();
+        keep(sum);
+    });
+    bench.run("pop_short/1m_x256", 2 * 256, [&] { work = src_large; }, [&] {
+        uint sum = 0;
+        for (int i = 0; i < 256; ++i)
+            sum += work.pop_short();
+        keep(sum);
+    });
+    bench.run("pop_int/4k_drain", page, [&] { work = src_page; }, [&] {
+        uint sum = 0;
+        while (work.size() >= 4)
+            sum += work.pop_int();
+        keep(sum);
+    });
+
+    /*十六进制*/
+    bench.run("to_hexstring/4k", page, [&] { auto h = src_page.to_hexstring(); keep(h); });
+    bench.run("to_hexstring/4k_split", page, [&] { auto h = src_page.to_hexstring(" "); keep(h); });
+    bench.run("from_hexstring/4k", page, [&] { ustring s; s.from_hexstring(hex_page); keep(s); });
+
+    /*随机*/
+    bench.run("gen_random_ustring/4k", page, [&] { auto s = ustring::gen_random_ustring(page); keep(s); });
+    bench.run("gen_secure_ustring/4k", page, [&] { auto s = ustring::gen_secure_ustring(page); keep(s); });
+    ustring random_large(large);
+    bench.run("fast_random::fill/1m", large, [&] { fast_random::fill(&random_large[0], random_large.size()); keep(random_large); });
+    bench.run("secure_random::fill/1m", large, [&] { secure_random::fill(&random_large[0], random_large.size()); keep(random_large); });
+
+    /*复制与移动*/
+    uchar raw_dest[256];
+    bench.run("memcpy/256", 256, [&] { memcpy(raw_dest, src_page.data(), 256); keep(raw_dest); });
+    ustring src_256(src_page.data(), 256);
+    bench.run("copy/256", 256, [&] { ustring s(src_256); keep(s); });
+    bench.run("copy/4k", page, [&] { ustring s(src_page); keep(s); });
+    bench.run("copy/1m", large, [&] { ustring s(src_large); keep(s); });
+    ustring moving = src_large;
+    bench.run("move/1m", 0, [&] {
+        ustring s(std::move(moving));
+        moving = std::move(s);
+        keep(moving);
+    });
+
+    bench.report();
+    return 0;
+}
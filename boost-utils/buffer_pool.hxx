@@ -0,0 +1,469 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月19日  13:02:16
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: buffer_pool.hxx
+//  描述: 分级内存池与对应的STL分配器，供报文大小的字节串使用
+// **************************************************************************/
+#pragma once
+
+#include "ustring.hxx"
+#include <boost/thread/mutex.hpp>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief 分级内存池
+ *
+ * 按 64B 到 64KB 的 2 的幂划分为 11 个级别，每个线程各有一份空闲链表缓存，
+ * 命中时只访问本线程的缓存，不加锁也没有原子读改写；线程缓存满了或者空了再与全局仓库成批交换。
+ * 超过 64KB 的请求直接交给系统分配。trim() 立即释放全局仓库，并经由缓存登记表通知各线程，
+ * 线程缓存在所属线程下次分配、归还或退出时释放，空闲线程的缓存会保留到那时。
+ */
+class buffer_pool final {
+public:
+    /**
+     * \brief 互斥量定义
+     */
+    using _Mutex = boost::mutex;
+
+    /**
+     * \brief 最小级别字节数
+     */
+    static const size_t min_block = 64;
+    /**
+     * \brief 最大级别字节数
+     */
+    static const size_t max_block = 64 * 1024;
+    /**
+     * \brief 级别个数
+     */
+    static const size_t class_count = 11;
+    /**
+     * \brief 每个线程每个级别最多缓存的字节数
+     */
+    static const size_t thread_cache_bytes = 256 * 1024;
+
+    /**
+     * \brief 统计信息
+     */
+    struct stats {
+        /**
+         * \brief 由线程缓存或全局仓库满足的分配次数
+         */
+        ulong64 hits{ 0 };
+        /**
+         * \brief 需要向系统申请的分配次数
+         */
+        ulong64 misses{ 0 };
+        /**
+         * \brief 超出最大级别、直接向系统申请的次数
+         */
+        ulong64 oversize{ 0 };
+        /**
+         * \brief 池中缓存、尚未归还系统的字节数
+         */
+        ulong64 bytes_retained{ 0 };
+    };
+
+    /**
+     * \brief 获取单例
+     * \return 单例
+     */
+    static buffer_pool &instance() {
+        static buffer_pool _inst;
+        return _inst;
+    }
+
+    /**
+     * \brief 分配内存
+     * \param n 字节数
+     * \return 内存指针
+     */
+    void *allocate(size_t n) {
+        auto c = class_of(n);
+        if (c == class_count) {
+            oversize.fetch_add(1, std::memory_order_relaxed);
+            return ::operator new(n);
+        }
+        auto tc = thread_cache();
+        if (!tc)
+            return ::operator new(class_size(c));
+        tc->poll_trim();
+        auto b = tc->pop(c);
+        if (!b) {
+            refill(*tc, c);
+            b = tc->pop(c);
+        }
+        if (b) {
+            tc->add(tc->hits, 1);
+            return b;
+        }
+        tc->add(tc->misses, 1);
+        return ::operator new(class_size(c));
+    }
+
+    /**
+     * \brief 归还内存
+     * \param p 内存指针
+     * \param n 分配时的字节数
+     */
+    void deallocate(void *p, size_t n) {
+        auto c = class_of(n);
+        if (c == class_count) {
+            ::operator delete(p);
+            return;
+        }
+        auto tc = thread_cache();
+        if (!tc) {
+            ::operator delete(p);
+            return;
+        }
+        tc->poll_trim();
+        auto count = tc->push(c, static_cast<_Block *>(p));
+        if (count > cache_limit(c))
+            spill(tc->take(c, count / 2), c);
+    }
+
+    /**
+     * \brief 回收空闲内存：全局仓库立即归还系统，各线程缓存由所属线程下次访问时归还
+     */
+    void trim() {
+        _Mutex::scoped_lock lock(mu);
+        for (auto tc : caches)
+            tc->trim_requested.store(true, std::memory_order_relaxed);
+        for (size_t c = 0; c < class_count; ++c) {
+            _FreeList all;
+            std::swap(all, depot[c]);
+            release(all);
+        }
+    }
+
+    /**
+     * \brief 取得统计快照
+     * \return 统计信息
+     */
+    stats get_stats() const {
+        stats s;
+        _Mutex::scoped_lock lock(mu);
+        s.hits = exited_hits;
+        s.misses = exited_misses;
+        for (size_t c = 0; c < class_count; ++c)
+            s.bytes_retained += depot[c].count * class_size(c);
+        for (auto tc : caches) {
+            s.hits += tc->hits.load(std::memory_order_relaxed);
+            s.misses += tc->misses.load(std::memory_order_relaxed);
+            s.bytes_retained += tc->bytes.load(std::memory_order_relaxed);
+        }
+        s.oversize = oversize.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    /**
+     * \brief 计算字节数所属级别
+     * \param n 字节数
+     * \return 级别，超出最大级别返回 class_count
+     */
+    static size_t class_of(size_t n) {
+        if (n > max_block)
+            return class_count;
+        size_t c = 0;
+        size_t sz = min_block;
+        while (sz < n) {
+            sz <<= 1;
+            ++c;
+        }
+        return c;
+    }
+
+    /**
+     * \brief 级别对应的块大小
+     * \param c 级别
+     * \return 字节数
+     */
+    static size_t class_size(size_t c) { return min_block << c; }
+
+private:
+
+    /**
+     * \brief 空闲块，空闲时复用块本身的内存作为链表节点
+     */
+    struct _Block {
+        _Block *next;
+    };
+
+    /**
+     * \brief 空闲链表
+     */
+    struct _FreeList {
+        _Block *head{ nullptr };
+        size_t  count{ 0 };
+    };
+
+    /**
+     * \brief 线程缓存，线程退出时交回全局仓库
+     *
+     * 链表只由所属线程访问，不加锁。trim() 不直接取走其他线程的块，只置位 trim_requested，
+     * 所属线程在下次分配或归还时检查并释放全部缓存。
+     * 统计只由所属线程写入，用 load/store 累加，不使用跨线程的原子加。
+     */
+    struct _ThreadCache {
+        _FreeList               lists[class_count];
+        std::atomic<ulong64>    hits{ 0 };
+        std::atomic<ulong64>    misses{ 0 };
+        /**
+         * \brief 缓存中的字节数
+         */
+        std::atomic<ulong64>    bytes{ 0 };
+        /**
+         * \brief trim() 请求释放缓存
+         */
+        std::atomic<bool>       trim_requested{ false };
+        buffer_pool             *owner{ nullptr };
+
+        void add(std::atomic<ulong64> &counter, ulong64 n) {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        void sub_bytes(ulong64 n) {
+            bytes.store(bytes.load(std::memory_order_relaxed) - n, std::memory_order_relaxed);
+        }
+
+        /**
+         * \brief 有 trim() 请求时把全部缓存归还系统
+         */
+        void poll_trim() {
+            if (!trim_requested.load(std::memory_order_relaxed))
+                return;
+            trim_requested.store(false, std::memory_order_relaxed);
+            for (size_t c = 0; c < class_count; ++c)
+                release(take(c, ~size_t(0)));
+        }
+
+        _Block *pop(size_t c) {
+            auto &list = lists[c];
+            auto b = list.head;
+            if (b) {
+                list.head = b->next;
+                --list.count;
+                sub_bytes(class_size(c));
+            }
+            return b;
+        }
+
+        /**
+         * \return 放入后该级别的块数
+         */
+        size_t push(size_t c, _Block *b) {
+            auto &list = lists[c];
+            b->next = list.head;
+            list.head = b;
+            add(bytes, class_size(c));
+            return ++list.count;
+        }
+
+        /**
+         * \brief 把一串块并入缓存
+         */
+        void splice(size_t c, _FreeList chain) {
+            if (!chain.head)
+                return;
+            auto &list = lists[c];
+            auto tail = chain.head;
+            while (tail->next)
+                tail = tail->next;
+            tail->next = list.head;
+            list.head = chain.head;
+            list.count += chain.count;
+            add(bytes, chain.count * class_size(c));
+        }
+
+        /**
+         * \brief 取走至多n个块
+         */
+        _FreeList take(size_t c, size_t n) {
+            _FreeList out;
+            auto &list = lists[c];
+            while (list.head && n--) {
+                auto b = list.head;
+                list.head = b->next;
+                --list.count;
+                b->next = out.head;
+                out.head = b;
+                ++out.count;
+            }
+            sub_bytes(out.count * class_size(c));
+            return out;
+        }
+
+        ~_ThreadCache() {
+            if (!owner)
+                return;
+            poll_trim();
+            for (size_t c = 0; c < class_count; ++c)
+                owner->spill(take(c, ~size_t(0)), c);
+            owner->unregister_cache(this);
+        }
+    };
+
+    buffer_pool() = default;
+    buffer_pool(const buffer_pool &) = delete;
+    buffer_pool &operator=(const buffer_pool &) = delete;
+
+    /**
+     * \brief 取得本线程缓存，首次访问时登记
+     * \return 缓存，登记失败返回空，调用者直接使用系统分配
+     */
+    _ThreadCache *thread_cache() noexcept {
+        static thread_local _ThreadCache tc;
+        if (!tc.owner) {
+            try {
+                _Mutex::scoped_lock lock(mu);
+                caches.push_back(&tc);
+            }
+            catch (...) {
+                return nullptr;
+            }
+            tc.owner = this;
+        }
+        return &tc;
+    }
+
+    void unregister_cache(_ThreadCache *tc) {
+        _Mutex::scoped_lock lock(mu);
+        exited_hits += tc->hits.load(std::memory_order_relaxed);
+        exited_misses += tc->misses.load(std::memory_order_relaxed);
+        for (auto it = caches.begin(); it != caches.end(); ++it) {
+            if (*it == tc) {
+                caches.erase(it);
+                break;
+            }
+        }
+    }
+
+    /**
+     * \brief 每个级别线程缓存的块数上限
+     */
+    static size_t cache_limit(size_t c) {
+        auto n = thread_cache_bytes / class_size(c);
+        return n < 4 ? 4 : n;
+    }
+
+    /**
+     * \brief 从全局仓库取一批块到线程缓存
+     */
+    void refill(_ThreadCache &tc, size_t c) {
+        _FreeList chain;
+        {
+            _Mutex::scoped_lock lock(mu);
+            auto &from = depot[c];
+            auto n = cache_limit(c) / 2;
+            while (from.head && n--) {
+                auto b = from.head;
+                from.head = b->next;
+                --from.count;
+                b->next = chain.head;
+                chain.head = b;
+                ++chain.count;
+            }
+        }
+        tc.splice(c, chain);
+    }
+
+    /**
+     * \brief 把从线程缓存取下的一串块交回全局仓库
+     */
+    void spill(_FreeList chain, size_t c) {
+        if (!chain.head)
+            return;
+        auto tail = chain.head;
+        while (tail->next)
+            tail = tail->next;
+        _Mutex::scoped_lock lock(mu);
+        auto &to = depot[c];
+        tail->next = to.head;
+        to.head = chain.head;
+        to.count += chain.count;
+    }
+
+    /**
+     * \brief 把一串块归还系统
+     */
+    static void release(_FreeList chain) {
+        auto b = chain.head;
+        while (b) {
+            auto next = b->next;
+            ::operator delete(b);
+            b = next;
+        }
+    }
+
+    /**
+     * \brief 互斥量，保护全局仓库与线程缓存登记表
+     */
+    mutable _Mutex              mu;
+    /**
+     * \brief 全局仓库
+     */
+    _FreeList                   depot[class_count];
+    /**
+     * \brief 存活线程的缓存
+     */
+    std::vector<_ThreadCache *> caches;
+    /**
+     * \brief 已退出线程的命中统计
+     */
+    ulong64                     exited_hits{ 0 };
+    ulong64                     exited_misses{ 0 };
+    /**
+     * \brief 超大分配次数
+     */
+    std::atomic<ulong64>        oversize{ 0 };
+};
+
+/**
+ * \brief 使用 buffer_pool 的 STL 分配器，无状态，所有实例相等
+ * \tparam T 元素类型
+ */
+template<class T>
+class pool_allocator {
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    template<class U>
+    struct rebind {
+        using other = pool_allocator<U>;
+    };
+
+    pool_allocator() noexcept {}
+
+    template<class U>
+    pool_allocator(const pool_allocator<U> &) noexcept {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(buffer_pool::instance().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t n) noexcept {
+        buffer_pool::instance().deallocate(p, n * sizeof(T));
+    }
+};
+
+template<class T, class U>
+inline bool operator==(const pool_allocator<T> &, const pool_allocator<U> &) { return true; }
+
+template<class T, class U>
+inline bool operator!=(const pool_allocator<T> &, const pool_allocator<U> &) { return false; }
+
+/**
+ * \brief 使用内存池分配的字节串
+ */
+using pooled_ustring = basic_ustring<pool_allocator<uchar>>;
@@ -0,0 +1,351 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月20日  16:11:05
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: byte_ops.hxx
+//  描述: 批量字节运算：循环密钥异或、常量时间比较、数组字节序转换
+// **************************************************************************/
+#pragma once
+
+#include "cpu_features.hxx"
+#include "ustring_view.hxx"
+#include <cstring>
+#include <type_traits>
+
+namespace byte_ops_detail {
+
+    /**
+     * \brief SIMD 异或支持的最长密钥，更长的密钥走标量
+     */
+    const size_t max_simd_key = 256;
+
+    /**
+     * \brief 展开后的密钥流：key[phase..] 后面接足够长的重复，任意位置起连续读取32字节都不越界
+     */
+    struct key_stream {
+        uchar   bytes[max_simd_key + 32];
+        size_t  len;
+
+        key_stream(const uchar *key, size_t klen) : len(klen) {
+            for (size_t i = 0; i < klen + 32; ++i)
+                bytes[i] = key[i % klen];
+        }
+    };
+
+    /**
+     * \brief 标量异或
+     * \return 结束时的密钥位置
+     */
+    inline size_t xor_scalar(const uchar *in, uchar *out, size_t n, const uchar *key, size_t klen, size_t phase) {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = in[i] ^ key[phase];
+            if (++phase == klen)
+                phase = 0;
+        }
+        return phase;
+    }
+
+#ifdef BU_ARCH_X64
+    /**
+     * \brief SSE2 异或，每次16字节，处理后 in/out/n/phase 指向剩余部分
+     */
+    inline void xor_sse2(const uchar *&in, uchar *&out, size_t &n, const key_stream &ks, size_t &phase) {
+        for (; n >= 16; n -= 16, in += 16, out += 16) {
+            auto k = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ks.bytes + phase));
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_xor_si128(v, k));
+            phase = (phase + 16) % ks.len;
+        }
+    }
+
+    /**
+     * \brief AVX2 异或，每次32字节
+     */
+    BU_TARGET("avx2")
+    inline void xor_avx2(const uchar *&in, uchar *&out, size_t &n, const key_stream &ks, size_t &phase) {
+        for (; n >= 32; n -= 32, in += 32, out += 32) {
+            auto k = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ks.bytes + phase));
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_xor_si256(v, k));
+            phase = (phase + 32) % ks.len;
+        }
+    }
+
+    /**
+     * \brief SSE2 累积差异，不提前退出
+     */
+    inline uchar diff_sse2(const uchar *&a, const uchar *&b, size_t &n) {
+        auto acc = _mm_setzero_si128();
+        for (; n >= 16; n -= 16, a += 16, b += 16) {
+            auto va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a));
+            auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+            acc = _mm_or_si128(acc, _mm_xor_si128(va, vb));
+        }
+        /*非零字节数折叠为一个字节*/
+        auto zero = static_cast<uint>(_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())));
+        return static_cast<uchar>((zero ^ 0xFFFF) != 0);
+    }
+
+    BU_TARGET("avx2")
+    inline uchar diff_avx2(const uchar *&a, const uchar *&b, size_t &n) {
+        auto acc = _mm256_setzero_si256();
+        for (; n >= 32; n -= 32, a += 32, b += 32) {
+            auto va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a));
+            auto vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b));
+            acc = _mm256_or_si256(acc, _mm256_xor_si256(va, vb));
+        }
+        auto zero = static_cast<uint>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(acc, _mm256_setzero_si256())));
+        return static_cast<uchar>(zero != 0xFFFFFFFFu);
+    }
+
+    /**
+     * \brief 各宽度元素的字节翻转表，两个128位通道相同
+     */
+    inline const uchar *swap_mask(size_t width) {
+        alignas(32) static const uchar m16[32] = {
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 };
+        alignas(32) static const uchar m32[32] = {
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 };
+        alignas(32) static const uchar m64[32] = {
+            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 };
+        return width == 2 ? m16 : width == 4 ? m32 : m64;
+    }
+
+    /**
+     * \brief SSSE3 字节翻转，每次16字节
+     */
+    BU_TARGET("ssse3")
+    inline void bswap_ssse3(uchar *&p, size_t &bytes, size_t width) {
+        auto m = _mm_load_si128(reinterpret_cast<const __m128i *>(swap_mask(width)));
+        for (; bytes >= 16; bytes -= 16, p += 16) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm_shuffle_epi8(v, m));
+        }
+    }
+
+    /**
+     * \brief AVX2 字节翻转，每次32字节
+     */
+    BU_TARGET("avx2")
+    inline void bswap_avx2(uchar *&p, size_t &bytes, size_t width) {
+        auto m = _mm256_load_si256(reinterpret_cast<const __m256i *>(swap_mask(width)));
+        for (; bytes >= 32; bytes -= 32, p += 32) {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), _mm256_shuffle_epi8(v, m));
+        }
+    }
+#endif
+
+    inline ushort bswap(ushort v) {
+#ifdef _MSC_VER
+        return _byteswap_ushort(v);
+#else
+        return __builtin_bswap16(v);
+#endif
+    }
+
+    inline uint bswap(uint v) {
+#ifdef _MSC_VER
+        return _byteswap_ulong(v);
+#else
+        return __builtin_bswap32(v);
+#endif
+    }
+
+    inline qword bswap(qword v) {
+#ifdef _MSC_VER
+        return _byteswap_uint64(v);
+#else
+        return __builtin_bswap64(v);
+#endif
+    }
+
+    /**
+     * \brief 按宽度取无符号类型
+     */
+    template<size_t W> struct uint_of;
+    template<> struct uint_of<2> { using type = ushort; };
+    template<> struct uint_of<4> { using type = uint; };
+    template<> struct uint_of<8> { using type = qword; };
+
+    /**
+     * \brief 标量字节翻转
+     */
+    template<class T>
+    inline void bswap_scalar(uchar *p, size_t count) {
+        for (size_t i = 0; i < count; ++i, p += sizeof(T)) {
+            T v;
+            memcpy(&v, p, sizeof(T));
+            v = bswap(v);
+            memcpy(p, &v, sizeof(T));
+        }
+    }
+
+    /**
+     * \brief 就地翻转 count 个宽度为 sizeof(T) 的元素，按 CPU 能力分派
+     */
+    template<class T>
+    inline void bswap_array(uchar *p, size_t count) {
+        auto bytes = count * sizeof(T);
+#ifdef BU_ARCH_X64
+        auto &f = cpu_features::get();
+        if (f.avx2)
+            bswap_avx2(p, bytes, sizeof(T));
+        if (f.ssse3)
+            bswap_ssse3(p, bytes, sizeof(T));
+#endif
+        bswap_scalar<T>(p, bytes / sizeof(T));
+    }
+
+    /**
+     * \brief 本机是否为小端
+     */
+    inline bool little_endian() {
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        return false;
+#else
+        return true;
+#endif
+    }
+}
+
+/**
+ * \brief 批量字节运算，均按 CPU 能力选择 AVX2/SSE 实现，不支持时使用标量实现
+ */
+struct byte_ops final {
+
+    /**
+     * \brief 循环密钥异或，in 与 out 可以相同（就地）
+     * \param in 输入
+     * \param out 输出，至少 n 字节
+     * \param n 字节数
+     * \param key 密钥，为空时原样复制
+     * \param phase 第一个字节对应的密钥位置，分段处理时传入上一段的返回值
+     * \return 下一个字节对应的密钥位置
+     */
+    static size_t xor_mask(const uchar *in, uchar *out, size_t n, ustring_view key, size_t phase = 0) {
+        using namespace byte_ops_detail;
+        auto klen = key.size();
+        if (klen == 0) {
+            if (in != out && n)
+                memmove(out, in, n);
+            return 0;
+        }
+        phase %= klen;
+#ifdef BU_ARCH_X64
+        if (klen <= max_simd_key && n >= 16) {
+            key_stream ks(key.data(), klen);
+            if (cpu_features::get().avx2)
+                xor_avx2(in, out, n, ks, phase);
+            xor_sse2(in, out, n, ks, phase);
+        }
+#endif
+        return xor_scalar(in, out, n, key.data(), klen, phase);
+    }
+
+    /**
+     * \brief 就地循环密钥异或，例如 WebSocket 掩码
+     * \param s 字节串
+     * \param key 密钥，为空时不变
+     * \param phase 起始密钥位置
+     * \return 下一个字节对应的密钥位置
+     */
+    template<class _Alloc>
+    static size_t xor_mask(basic_ustring<_Alloc> &s, ustring_view key, size_t phase = 0) {
+        auto p = &s[0];
+        return xor_mask(p, p, s.size(), key, phase);
+    }
+
+    /**
+     * \brief 循环密钥异或，结果追加到 out
+     * \param in 输入
+     * \param out 输出
+     * \param key 密钥，为空时原样追加
+     * \param phase 起始密钥位置
+     * \return 下一个字节对应的密钥位置
+     */
+    template<class _Alloc>
+    static size_t xor_mask(ustring_view in, basic_ustring<_Alloc> &out, ustring_view key, size_t phase = 0) {
+        auto old = out.size();
+        out.resize(old + in.size());
+        return xor_mask(in.data(), &out[0] + old, in.size(), key, phase);
+    }
+
+    /**
+     * \brief 常量时间比较，耗时只与长度有关，与内容和首个差异位置无关，用于比较 MAC、令牌等
+     * \param a 数据
+     * \param b 数据
+     * \return 是否相等，长度不同直接返回false
+     */
+    static bool equal_ct(ustring_view a, ustring_view b) {
+        using namespace byte_ops_detail;
+        if (a.size() != b.size())
+            return false;
+        auto pa = a.data();
+        auto pb = b.data();
+        auto n = a.size();
+        uchar diff = 0;
+#ifdef BU_ARCH_X64
+        if (cpu_features::get().avx2)
+            diff |= diff_avx2(pa, pb, n);
+        diff |= diff_sse2(pa, pb, n);
+#endif
+        /*volatile 防止编译器把尾部循环改为提前退出*/
+        volatile uchar tail = 0;
+        for (size_t i = 0; i < n; ++i)
+            tail = static_cast<uchar>(tail | (pa[i] ^ pb[i]));
+        return (diff | tail) == 0;
+    }
+
+    /**
+     * \brief 就地在大端与本机字节序之间转换，转换是对称的，两个方向相同
+     * \tparam T ushort/uint/qword
+     * \param p 数组
+     * \param count 元素个数
+     */
+    template<class T>
+    static void big_endian_inplace(T *p, size_t count) {
+        static_assert(sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "element must be 2, 4 or 8 bytes");
+        static_assert(std::is_integral<T>::value, "element must be integral");
+        if (byte_ops_detail::little_endian())
+            byte_ops_detail::bswap_array<typename byte_ops_detail::uint_of<sizeof(T)>::type>(reinterpret_cast<uchar *>(p), count);
+    }
+
+    /**
+     * \brief 从网络数据读取大端数组
+     * \tparam T ushort/uint/qword
+     * \param in 数据，至少 count * sizeof(T) 字节
+     * \param out 输出数组
+     * \param count 元素个数
+     */
+    template<class T>
+    static void read_be(const uchar *in, T *out, size_t count) {
+        if (count == 0)
+            return;
+        memcpy(out, in, count * sizeof(T));
+        big_endian_inplace(out, count);
+    }
+
+    /**
+     * \brief 将数组按大端写出，追加到 out
+     * \tparam T ushort/uint/qword
+     * \param out 输出
+     * \param in 数组
+     * \param count 元素个数
+     */
+    template<class _Alloc, class T>
+    static void append_be(basic_ustring<_Alloc> &out, const T *in, size_t count) {
+        if (count == 0)
+            return;
+        auto old = out.size();
+        out.resize(old + count * sizeof(T));
+        auto p = &out[0] + old;
+        memcpy(p, in, count * sizeof(T));
+        if (byte_ops_detail::little_endian())
+            byte_ops_detail::bswap_array<typename byte_ops_detail::uint_of<sizeof(T)>::type>(p, count);
+    }
+};
@@ -0,0 +1,473 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月19日  17:12:26
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: byte_search.hxx
+//  描述: 字节串查找：单模式 SIMD/Horspool 查找与 Aho-Corasick 多模式流式匹配
+// **************************************************************************/
+#pragma once
+
+#include "ustring_view.hxx"
+#include "cpu_features.hxx"
+#include <cstring>
+#include <vector>
+#include <queue>
+
+namespace search_detail {
+
+    /**
+     * \brief 最低位1的位置，mask 不能为0
+     */
+    inline int ctz(uint mask) {
+#ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanForward(&idx, mask);
+        return static_cast<int>(idx);
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+#ifdef BU_ARCH_X64
+    /**
+     * \brief SSE2 首尾字节过滤，命中后再比较中间部分，m >= 2
+     * \return 找到返回位置，否则返回已检查到的位置 i 并置 found 为false
+     */
+    inline size_t find_sse2(const uchar *s, size_t n, const uchar *p, size_t m, size_t i, bool &found) {
+        const auto first = _mm_set1_epi8(static_cast<char>(p[0]));
+        const auto last = _mm_set1_epi8(static_cast<char>(p[m - 1]));
+        for (; i + m - 1 + 16 <= n; i += 16) {
+            auto bf = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+            auto bl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i + m - 1));
+            auto mask = static_cast<uint>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(first, bf), _mm_cmpeq_epi8(last, bl))));
+            while (mask) {
+                auto bit = static_cast<size_t>(ctz(mask));
+                if (std::memcmp(s + i + bit + 1, p + 1, m - 2) == 0) {
+                    found = true;
+                    return i + bit;
+                }
+                mask &= mask - 1;
+            }
+        }
+        found = false;
+        return i;
+    }
+
+    /**
+     * \brief AVX2 首尾字节过滤，每次32字节
+     */
+    BU_TARGET("avx2")
+    inline size_t find_avx2(const uchar *s, size_t n, const uchar *p, size_t m, size_t i, bool &found) {
+        const auto first = _mm256_set1_epi8(static_cast<char>(p[0]));
+        const auto last = _mm256_set1_epi8(static_cast<char>(p[m - 1]));
+        for (; i + m - 1 + 32 <= n; i += 32) {
+            auto bf = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+            auto bl = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i + m - 1));
+            auto mask = static_cast<uint>(_mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(first, bf), _mm256_cmpeq_epi8(last, bl))));
+            while (mask) {
+                auto bit = static_cast<size_t>(ctz(mask));
+                if (std::memcmp(s + i + bit + 1, p + 1, m - 2) == 0) {
+                    found = true;
+                    return i + bit;
+                }
+                mask &= mask - 1;
+            }
+        }
+        found = false;
+        return i;
+    }
+#endif
+}
+
+/**
+ * \brief 单模式查找器，构造时预处理模式，可重复用于多个缓冲区
+ *
+ * 单字节模式走 memchr；x64 上先用 AVX2/SSE2 比较首尾字节筛选候选位置，
+ * 剩余部分与其他平台使用 Horspool。
+ */
+class byte_searcher final {
+public:
+    /**
+     * \brief 未找到
+     */
+    static const size_t npos = static_cast<size_t>(-1);
+
+    /**
+     * \brief 构造
+     * \param pattern 模式，查找器内部保存一份拷贝
+     */
+    explicit byte_searcher(ustring_view pattern) : pat(pattern.data(), pattern.size()) {
+        auto m = pat.size();
+        for (auto &s : shift)
+            s = m;
+        for (size_t i = 0; i + 1 < m; ++i)
+            shift[pat[i]] = m - 1 - i;
+    }
+
+    /**
+     * \brief 模式长度
+     * \return 长度
+     */
+    size_t size() const { return pat.size(); }
+
+    /**
+     * \brief 在缓冲区中查找
+     * \param hay 缓冲区
+     * \param from 起始位置
+     * \return 第一次出现的位置，未找到返回 npos
+     */
+    size_t find(ustring_view hay, size_t from = 0) const {
+        auto s = hay.data();
+        auto n = hay.size();
+        auto m = pat.size();
+        auto p = pat.data();
+        if (from > n || m > n - from)
+            return npos;
+        if (m == 0)
+            return from;
+        if (m == 1) {
+            auto r = static_cast<const uchar *>(std::memchr(s + from, p[0], n - from));
+            return r ? static_cast<size_t>(r - s) : npos;
+        }
+        auto i = from;
+#ifdef BU_ARCH_X64
+        bool found = false;
+        if (cpu_features::get().avx2) {
+            i = search_detail::find_avx2(s, n, p, m, i, found);
+            if (found)
+                return i;
+        }
+        i = search_detail::find_sse2(s, n, p, m, i, found);
+        if (found)
+            return i;
+#endif
+        return horspool(s, n, i);
+    }
+
+    /**
+     * \brief 在链式缓冲中查找，可以找到跨越分段边界的匹配
+     * \tparam _Chain 链式缓冲类型
+     * \param chain 链式缓冲
+     * \return 以整条链计算的位置，未找到返回 npos
+     */
+    template<class _Chain>
+    size_t find_chain(const _Chain &chain) const {
+        auto m = pat.size();
+        if (m == 0)
+            return 0;
+        size_t base = 0;
+        size_t result = npos;
+        /*上一段末尾不足一个模式长度的字节，用来拼接检查跨段匹配*/
+        ustring tail;
+        for_each_segment(chain, [&](ustring_view seg) {
+            if (result != npos)
+                return;
+            if (m > 1 && !tail.empty()) {
+                auto join = tail;
+                join.append(seg.data(), std::min(seg.size(), m - 1));
+                auto r = find(make_view(join));
+                if (r != npos) {
+                    result = base - tail.size() + r;
+                    return;
+                }
+            }
+            auto r = find(seg);
+            if (r != npos) {
+                result = base + r;
+                return;
+            }
+            if (m > 1) {
+                if (seg.size() >= m - 1)
+                    tail.assign(seg.data() + seg.size() - (m - 1), m - 1);
+                else {
+                    tail.append(seg.data(), seg.size());
+                    if (tail.size() > m - 1)
+                        tail.erase(0, tail.size() - (m - 1));
+                }
+            }
+            base += seg.size();
+        });
+        return result;
+    }
+
+private:
+
+    size_t horspool(const uchar *s, size_t n, size_t i) const {
+        auto m = pat.size();
+        auto p = pat.data();
+        auto lastc = p[m - 1];
+        while (i + m <= n) {
+            auto c = s[i + m - 1];
+            if (c == lastc && std::memcmp(s + i, p, m - 1) == 0)
+                return i;
+            i += shift[c];
+        }
+        return npos;
+    }
+
+    /**
+     * \brief 模式
+     */
+    ustring     pat;
+    /**
+     * \brief Horspool 坏字符跳转表
+     */
+    size_t      shift[256];
+};
+
+/**
+ * \brief 查找字节串
+ * \param hay 缓冲区
+ * \param needle 模式
+ * \param from 起始位置
+ * \return 第一次出现的位置，未找到返回 byte_searcher::npos
+ */
+inline size_t find_bytes(ustring_view hay, ustring_view needle, size_t from = 0) {
+    return byte_searcher(needle).find(hay, from);
+}
+
+/**
+ * \brief Aho-Corasick 多模式匹配器，使用稠密状态转移表（状态数 x 256），
+ * 编译后只读，可被多个线程共享；流式匹配的状态保存在 stream 中。
+ * 匹配回调的参数为模式序号与匹配结束位置（不含），起始位置为结束位置减模式长度
+ */
+class multi_matcher final {
+public:
+    /**
+     * \brief 流式匹配状态，匹配可以跨越多次 feed()
+     */
+    class stream {
+    public:
+        explicit stream(const multi_matcher &m) : matcher(&m) {}
+
+        /**
+         * \brief 输入一块数据
+         * \tparam _Func 回调类型，签名为 void(size_t pattern_id, qword end_offset)
+         * \param chunk 数据
+         * \param on_match 回调
+         */
+        template<class _Func>
+        void feed(ustring_view chunk, _Func &&on_match) {
+            state = matcher->run(state, pos, chunk, on_match);
+            pos += chunk.size();
+        }
+
+        /**
+         * \brief 已输入的字节数
+         */
+        qword position() const { return pos; }
+
+        /**
+         * \brief 重置到初始状态
+         */
+        void reset() {
+            state = 0;
+            pos = 0;
+        }
+
+    private:
+        const multi_matcher *matcher;
+        uint                state{ 0 };
+        qword               pos{ 0 };
+    };
+
+    /**
+     * \brief 编译模式集合
+     * \tparam _Patterns 模式容器类型，元素可转换为 ustring_view
+     * \param patterns 模式集合，空模式被忽略
+     */
+    template<class _Patterns>
+    explicit multi_matcher(const _Patterns &patterns) {
+        build_trie(patterns);
+        build_links();
+    }
+
+    multi_matcher(std::initializer_list<ustring_view> patterns) {
+        build_trie(patterns);
+        build_links();
+    }
+
+    /**
+     * \brief 模式个数
+     */
+    size_t pattern_count() const { return lengths.size(); }
+
+    /**
+     * \brief 模式长度
+     * \param id 模式序号
+     */
+    size_t pattern_length(size_t id) const { return lengths[id]; }
+
+    /**
+     * \brief 状态个数
+     */
+    size_t state_count() const { return outputs.size(); }
+
+    /**
+     * \brief 扫描一个缓冲区
+     * \tparam _Func 回调类型，签名为 void(size_t pattern_id, qword end_offset)
+     * \param hay 缓冲区
+     * \param on_match 回调
+     */
+    template<class _Func>
+    void scan(ustring_view hay, _Func &&on_match) const {
+        run(0, 0, hay, on_match);
+    }
+
+    /**
+     * \brief 扫描链式缓冲，跨段匹配同样上报
+     * \tparam _Chain 链式缓冲类型
+     * \tparam _Func 回调类型
+     * \param chain 链式缓冲
+     * \param on_match 回调
+     */
+    template<class _Chain, class _Func>
+    void scan_chain(const _Chain &chain, _Func &&on_match) const {
+        stream st(*this);
+        for_each_segment(chain, [&](ustring_view seg) { st.feed(seg, on_match); });
+    }
+
+    /**
+     * \brief 缓冲区中是否出现任一模式
+     * \param hay 缓冲区
+     * \return 是否出现
+     */
+    bool contains_any(ustring_view hay) const {
+        uint s = 0;
+        for (auto c : hay) {
+            s = next[static_cast<size_t>(s) * 256 + c];
+            if (outputs[s] != none)
+                return true;
+        }
+        return false;
+    }
+
+private:
+
+    /**
+     * \brief 空输出项
+     */
+    enum : uint { none = 0xFFFFFFFFu };
+
+    template<class _Func>
+    uint run(uint s, qword base, ustring_view hay, _Func &on_match) const {
+        auto p = hay.data();
+        auto n = hay.size();
+        auto table = next.data();
+        for (size_t i = 0; i < n; ++i) {
+            s = table[static_cast<size_t>(s) * 256 + p[i]];
+            /*沿输出链上报所有以当前位置结尾的模式*/
+            for (auto o = outputs[s]; o != none; o = output_link[o])
+                on_match(static_cast<size_t>(pattern_of[o]), base + i + 1);
+        }
+        return s;
+    }
+
+    uint new_state() {
+        next.resize(next.size() + 256, 0);
+        outputs.push_back(none);
+        fail.push_back(0);
+        return static_cast<uint>(outputs.size() - 1);
+    }
+
+    template<class _Patterns>
+    void build_trie(const _Patterns &patterns) {
+        new_state();
+        for (const auto &item : patterns) {
+            auto pat = static_cast<ustring_view>(item);
+            auto id = lengths.size();
+            lengths.push_back(pat.size());
+            if (pat.empty())
+                continue;
+            uint s = 0;
+            for (auto c : pat) {
+                auto &t = next[static_cast<size_t>(s) * 256 + c];
+                if (t == 0) {
+                    auto ns = new_state();
+                    next[static_cast<size_t>(s) * 256 + c] = ns;
+                    s = ns;
+                }
+                else {
+                    s = t;
+                }
+            }
+            /*同一状态可能对应多个相同的模式，用输出链串起来*/
+            pattern_of.push_back(static_cast<uint>(id));
+            output_link.push_back(outputs[s]);
+            outputs[s] = static_cast<uint>(pattern_of.size() - 1);
+        }
+    }
+
+    /**
+     * \brief 广度优先计算失败链接，并把 goto 表补全成 DFA
+     */
+    void build_links() {
+        std::queue<uint> q;
+        for (size_t c = 0; c < 256; ++c) {
+            auto t = next[c];
+            if (t != 0) {
+                fail[t] = 0;
+                q.push(t);
+            }
+        }
+        while (!q.empty()) {
+            auto s = q.front();
+            q.pop();
+            /*把失败状态的输出接到本状态输出链的末尾*/
+            append_outputs(s, fail[s]);
+            for (size_t c = 0; c < 256; ++c) {
+                auto &t = next[static_cast<size_t>(s) * 256 + c];
+                auto f = next[static_cast<size_t>(fail[s]) * 256 + c];
+                if (t != 0) {
+                    fail[t] = f;
+                    q.push(t);
+                }
+                else {
+                    t = f;
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief 本状态自己的输出项在链的前面，失败状态的整条链接在其后
+     */
+    void append_outputs(uint s, uint f) {
+        if (outputs[s] == none) {
+            outputs[s] = outputs[f];
+            return;
+        }
+        auto o = outputs[s];
+        while (output_link[o] != none)
+            o = output_link[o];
+        output_link[o] = outputs[f];
+    }
+
+    /**
+     * \brief 稠密转移表
+     */
+    std::vector<uint>   next;
+    /**
+     * \brief 失败链接，仅构建时使用
+     */
+    std::vector<uint>   fail;
+    /**
+     * \brief 每个状态输出链的第一项
+     */
+    std::vector<uint>   outputs;
+    /**
+     * \brief 输出项对应的模式序号
+     */
+    std::vector<uint>   pattern_of;
+    /**
+     * \brief 输出链的下一项
+     */
+    std::vector<uint>   output_link;
+    /**
+     * \brief 模式长度
+     */
+    std::vector<size_t> lengths;
+};
@@ -0,0 +1,526 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月19日  15:20:09
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: checksum.hxx
+//  描述: 校验与哈希：CRC32C（SSE4.2/PCLMUL 加速）、xxHash64、Adler-32，均支持流式计算
+// **************************************************************************/
+#pragma once
+
+#include "ustring_view.hxx"
+#include "cpu_features.hxx"
+#include <cstring>
+
+namespace checksum_detail {
+
+    /**
+     * \brief CRC32C 反射多项式
+     */
+    const uint crc32c_poly = 0x82F63B78u;
+
+    /**
+     * \brief 读取小端64位数
+     */
+    inline qword load_le64(const uchar *p) {
+        qword v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    /**
+     * \brief 读取小端32位数
+     */
+    inline dword load_le32(const uchar *p) {
+        dword v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    /**
+     * \brief 在 GF(2) 上计算 a*b mod P，反射表示，最高位表示 x^0
+     */
+    inline uint multmodp(uint a, uint b) {
+        uint m = 1u << 31, p = 0;
+        for (;;) {
+            if (a & m) {
+                p ^= b;
+                if ((a & (m - 1)) == 0)
+                    break;
+            }
+            m >>= 1;
+            b = b & 1 ? (b >> 1) ^ crc32c_poly : b >> 1;
+        }
+        return p;
+    }
+
+    /**
+     * \brief x^(2^k) mod P 表
+     */
+    struct crc32c_powers {
+        uint x2n[64];
+
+        crc32c_powers() {
+            uint p = 1u << 30;  //x^1
+            x2n[0] = p;
+            for (int k = 1; k < 64; ++k)
+                x2n[k] = p = multmodp(p, p);
+        }
+
+        static const crc32c_powers &get() {
+            static const crc32c_powers _inst;
+            return _inst;
+        }
+    };
+
+    /**
+     * \brief 计算 x^n mod P
+     * \param n 指数
+     * \return 反射表示的余式
+     */
+    inline uint xnmodp(qword n) {
+        auto &t = crc32c_powers::get();
+        uint p = 1u << 31;  //x^0
+        for (int k = 0; n; n >>= 1, ++k) {
+            if (n & 1)
+                p = multmodp(t.x2n[k], p);
+        }
+        return p;
+    }
+
+    /**
+     * \brief slicing-by-8 查表
+     */
+    struct crc32c_tables {
+        uint t[8][256];
+
+        crc32c_tables() {
+            for (uint i = 0; i < 256; ++i) {
+                uint c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = c & 1 ? (c >> 1) ^ crc32c_poly : c >> 1;
+                t[0][i] = c;
+            }
+            for (uint i = 0; i < 256; ++i) {
+                for (int s = 1; s < 8; ++s)
+                    t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+            }
+        }
+
+        static const crc32c_tables &get() {
+            static const crc32c_tables _inst;
+            return _inst;
+        }
+    };
+
+    /**
+     * \brief 查表实现，crc 为未取反的内部状态
+     */
+    inline uint crc32c_sw(uint crc, const uchar *p, size_t n) {
+        auto &t = crc32c_tables::get().t;
+        while (n >= 8) {
+            auto lo = load_le32(p) ^ crc;
+            auto hi = load_le32(p + 4);
+            crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+                ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+            p += 8;
+            n -= 8;
+        }
+        while (n--)
+            crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+        return crc;
+    }
+
+#ifdef BU_ARCH_X64
+    /**
+     * \brief SSE4.2 crc32 指令实现
+     */
+    BU_TARGET("sse4.2")
+    inline uint crc32c_hw(uint crc, const uchar *p, size_t n) {
+        qword c = crc;
+        while (n >= 8) {
+            c = _mm_crc32_u64(c, load_le64(p));
+            p += 8;
+            n -= 8;
+        }
+        auto c32 = static_cast<uint>(c);
+        while (n--)
+            c32 = _mm_crc32_u8(c32, *p++);
+        return c32;
+    }
+
+    /**
+     * \brief 大缓冲区三路交错计算，每路各自用 crc32 指令，
+     * 再用 PCLMUL 乘以 x^(8L) 把前两路折叠到第三路上
+     */
+    BU_TARGET("sse4.2,pclmul")
+    inline uint crc32c_hw_fold(uint crc, const uchar *p, size_t n) {
+        const size_t lane = 1024;
+        /*clmul 结果再经过一次 crc32 相当于多乘 x^33，因此常数取 x^(8L-33)*/
+        static const uint k1 = xnmodp(8 * lane - 33);
+        static const uint k2 = xnmodp(16 * lane - 33);
+        const auto mk1 = _mm_cvtsi32_si128(static_cast<int>(k1));
+        const auto mk2 = _mm_cvtsi32_si128(static_cast<int>(k2));
+
+        while (n >= 3 * lane) {
+            qword c0 = crc, c1 = 0, c2 = 0;
+            for (size_t i = 0; i < lane; i += 8) {
+                c0 = _mm_crc32_u64(c0, load_le64(p + i));
+                c1 = _mm_crc32_u64(c1, load_le64(p + lane + i));
+                c2 = _mm_crc32_u64(c2, load_le64(p + 2 * lane + i));
+            }
+            auto f0 = _mm_clmulepi64_si128(_mm_cvtsi32_si128(static_cast<int>(c0)), mk2, 0x00);
+            auto f1 = _mm_clmulepi64_si128(_mm_cvtsi32_si128(static_cast<int>(c1)), mk1, 0x00);
+            auto folded = static_cast<qword>(_mm_cvtsi128_si64(_mm_xor_si128(f0, f1)));
+            crc = static_cast<uint>(_mm_crc32_u64(0, folded)) ^ static_cast<uint>(c2);
+            p += 3 * lane;
+            n -= 3 * lane;
+        }
+        return crc32c_hw(crc, p, n);
+    }
+#endif
+
+    /**
+     * \brief 按 CPU 能力选择的实现
+     */
+    using crc32c_func = uint(*)(uint, const uchar *, size_t);
+
+    inline crc32c_func select_crc32c() {
+#ifdef BU_ARCH_X64
+        auto &f = cpu_features::get();
+        if (f.sse42 && f.pclmul)
+            return &crc32c_hw_fold;
+        if (f.sse42)
+            return &crc32c_hw;
+#endif
+        return &crc32c_sw;
+    }
+
+    inline qword rotl64(qword v, int r) {
+        return (v << r) | (v >> (64 - r));
+    }
+}
+
+/**
+ * \brief CRC32C（Castagnoli），可流式计算
+ */
+class crc32c final {
+public:
+    /**
+     * \brief 构造
+     * \param initial 之前已经计算出的校验值，用于接续计算
+     */
+    explicit crc32c(uint initial = 0) : state(~initial) {}
+
+    /**
+     * \brief 追加数据
+     * \param ptr 指针
+     * \param len 长度
+     * \return 当前实例
+     */
+    crc32c &update(const uchar *ptr, size_t len) {
+        static const auto impl = checksum_detail::select_crc32c();
+        state = impl(state, ptr, len);
+        return *this;
+    }
+
+    /**
+     * \brief 追加数据，ustring、shared_ustring 均可隐式转换为视图
+     * \param v 视图
+     * \return 当前实例
+     */
+    crc32c &update(ustring_view v) { return update(v.data(), v.size()); }
+
+    /**
+     * \brief 追加链式缓冲
+     * \tparam _Chain 链式缓冲类型
+     * \param chain 链式缓冲
+     * \return 当前实例
+     */
+    template<class _Chain>
+    crc32c &update_chain(const _Chain &chain) {
+        for_each_segment(chain, [this](ustring_view v) { update(v); });
+        return *this;
+    }
+
+    /**
+     * \brief 当前校验值
+     * \return 校验值
+     */
+    uint value() const { return ~state; }
+
+    /**
+     * \brief 重置
+     */
+    void reset() { state = ~0u; }
+
+    /**
+     * \brief 一次性计算
+     * \param v 数据
+     * \return 校验值
+     */
+    static uint compute(ustring_view v) { return crc32c().update(v).value(); }
+
+    /**
+     * \brief 合并两段的校验值
+     * \param crc1 前一段校验值
+     * \param crc2 后一段校验值
+     * \param len2 后一段长度
+     * \return 两段连接后的校验值
+     */
+    static uint combine(uint crc1, uint crc2, qword len2) {
+        return checksum_detail::multmodp(checksum_detail::xnmodp(len2 * 8), crc1) ^ crc2;
+    }
+
+private:
+    /**
+     * \brief 内部状态，已取反
+     */
+    uint    state;
+};
+
+/**
+ * \brief 64位 xxHash（XXH64），可流式计算
+ */
+class xxhash64 final {
+    static const qword P1 = 11400714785074694791ULL;
+    static const qword P2 = 14029467366897019727ULL;
+    static const qword P3 = 1609587929392839161ULL;
+    static const qword P4 = 9650029242287828579ULL;
+    static const qword P5 = 2870177450012600261ULL;
+
+public:
+    /**
+     * \brief 构造
+     * \param seed 种子
+     */
+    explicit xxhash64(qword seed = 0) { reset(seed); }
+
+    /**
+     * \brief 重置
+     * \param seed 种子
+     */
+    void reset(qword seed = 0) {
+        this->seed = seed;
+        v[0] = seed + P1 + P2;
+        v[1] = seed + P2;
+        v[2] = seed;
+        v[3] = seed - P1;
+        total = 0;
+        buffered = 0;
+    }
+
+    /**
+     * \brief 追加数据
+     * \param ptr 指针
+     * \param len 长度
+     * \return 当前实例
+     */
+    xxhash64 &update(const uchar *ptr, size_t len) {
+        using checksum_detail::load_le64;
+        total += len;
+        if (buffered + len < 32) {
+            std::memcpy(buf + buffered, ptr, len);
+            buffered += len;
+            return *this;
+        }
+        if (buffered) {
+            auto fill = 32 - buffered;
+            std::memcpy(buf + buffered, ptr, fill);
+            for (int i = 0; i < 4; ++i)
+                v[i] = round(v[i], load_le64(buf + 8 * i));
+            ptr += fill;
+            len -= fill;
+            buffered = 0;
+        }
+        while (len >= 32) {
+            v[0] = round(v[0], load_le64(ptr));
+            v[1] = round(v[1], load_le64(ptr + 8));
+            v[2] = round(v[2], load_le64(ptr + 16));
+            v[3] = round(v[3], load_le64(ptr + 24));
+            ptr += 32;
+            len -= 32;
+        }
+        std::memcpy(buf, ptr, len);
+        buffered = len;
+        return *this;
+    }
+
+    /**
+     * \brief 追加数据
+     * \param v 视图
+     * \return 当前实例
+     */
+    xxhash64 &update(ustring_view v) { return update(v.data(), v.size()); }
+
+    /**
+     * \brief 追加链式缓冲
+     * \tparam _Chain 链式缓冲类型
+     * \param chain 链式缓冲
+     * \return 当前实例
+     */
+    template<class _Chain>
+    xxhash64 &update_chain(const _Chain &chain) {
+        for_each_segment(chain, [this](ustring_view v) { update(v); });
+        return *this;
+    }
+
+    /**
+     * \brief 当前哈希值，不影响继续追加
+     * \return 哈希值
+     */
+    qword value() const {
+        using checksum_detail::rotl64;
+        qword h;
+        if (total >= 32) {
+            h = rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + rotl64(v[3], 18);
+            for (int i = 0; i < 4; ++i)
+                h = (h ^ round(0, v[i])) * P1 + P4;
+        }
+        else {
+            h = seed + P5;
+        }
+        h += total;
+
+        auto p = buf;
+        auto n = buffered;
+        while (n >= 8) {
+            h ^= round(0, checksum_detail::load_le64(p));
+            h = rotl64(h, 27) * P1 + P4;
+            p += 8;
+            n -= 8;
+        }
+        if (n >= 4) {
+            h ^= static_cast<qword>(checksum_detail::load_le32(p)) * P1;
+            h = rotl64(h, 23) * P2 + P3;
+            p += 4;
+            n -= 4;
+        }
+        while (n--) {
+            h ^= *p++ * P5;
+            h = rotl64(h, 11) * P1;
+        }
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    /**
+     * \brief 一次性计算
+     * \param v 数据
+     * \param seed 种子
+     * \return 哈希值
+     */
+    static qword compute(ustring_view v, qword seed = 0) { return xxhash64(seed).update(v).value(); }
+
+private:
+
+    static qword round(qword acc, qword input) {
+        acc += input * P2;
+        acc = checksum_detail::rotl64(acc, 31);
+        return acc * P1;
+    }
+
+    qword   seed;
+    qword   v[4];
+    qword   total;
+    uchar   buf[32];
+    size_t  buffered;
+};
+
+/**
+ * \brief Adler-32，可流式计算
+ */
+class adler32 final {
+    static const uint mod = 65521;
+    /**
+     * \brief 不溢出时最多可以累加的字节数
+     */
+    static const size_t nmax = 5552;
+
+public:
+    /**
+     * \brief 构造
+     * \param initial 之前已经计算出的校验值，用于接续计算
+     */
+    explicit adler32(uint initial = 1) : a(initial & 0xFFFF), b(initial >> 16) {}
+
+    /**
+     * \brief 追加数据
+     * \param ptr 指针
+     * \param len 长度
+     * \return 当前实例
+     */
+    adler32 &update(const uchar *ptr, size_t len) {
+        while (len > 0) {
+            auto n = len < nmax ? len : nmax;
+            len -= n;
+            while (n >= 8) {
+                a += ptr[0]; b += a;
+                a += ptr[1]; b += a;
+                a += ptr[2]; b += a;
+                a += ptr[3]; b += a;
+                a += ptr[4]; b += a;
+                a += ptr[5]; b += a;
+                a += ptr[6]; b += a;
+                a += ptr[7]; b += a;
+                ptr += 8;
+                n -= 8;
+            }
+            while (n--) {
+                a += *ptr++;
+                b += a;
+            }
+            a %= mod;
+            b %= mod;
+        }
+        return *this;
+    }
+
+    /**
+     * \brief 追加数据
+     * \param v 视图
+     * \return 当前实例
+     */
+    adler32 &update(ustring_view v) { return update(v.data(), v.size()); }
+
+    /**
+     * \brief 追加链式缓冲
+     * \tparam _Chain 链式缓冲类型
+     * \param chain 链式缓冲
+     * \return 当前实例
+     */
+    template<class _Chain>
+    adler32 &update_chain(const _Chain &chain) {
+        for_each_segment(chain, [this](ustring_view v) { update(v); });
+        return *this;
+    }
+
+    /**
+     * \brief 当前校验值
+     * \return 校验值
+     */
+    uint value() const { return (b << 16) | a; }
+
+    /**
+     * \brief 重置
+     */
+    void reset() {
+        a = 1;
+        b = 0;
+    }
+
+    /**
+     * \brief 一次性计算
+     * \param v 数据
+     * \return 校验值
+     */
+    static uint compute(ustring_view v) { return adler32().update(v).value(); }
+
+private:
+    uint    a;
+    uint    b;
+};
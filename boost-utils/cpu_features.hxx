@@ -0,0 +1,90 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月19日  15:02:51
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: cpu_features.hxx
+//  描述: CPU 指令集运行时检测，供 SIMD 快速路径分派使用
+// **************************************************************************/
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BU_ARCH_X64 1
+#endif
+
+#ifdef BU_ARCH_X64
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#endif
+
+/**
+ * \brief 为单个函数开启指令集，MSVC 不需要
+ */
+#if defined(BU_ARCH_X64) && (defined(__GNUC__) || defined(__clang__))
+#define BU_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BU_TARGET(isa)
+#endif
+
+/**
+ * \brief CPU 指令集检测结果，进程内只检测一次
+ */
+class cpu_features final {
+public:
+    bool ssse3{ false };
+    bool sse42{ false };
+    bool pclmul{ false };
+    bool avx2{ false };
+
+    /**
+     * \brief 获取检测结果
+     * \return 检测结果
+     */
+    static const cpu_features &get() {
+        static const cpu_features _inst;
+        return _inst;
+    }
+
+private:
+    cpu_features() {
+#ifdef BU_ARCH_X64
+        unsigned int r1[4] = { 0 }, r7[4] = { 0 };
+        cpuid(1, r1);
+        cpuid(7, r7);
+        ssse3 = (r1[2] & (1u << 9)) != 0;
+        sse42 = (r1[2] & (1u << 20)) != 0;
+        pclmul = (r1[2] & (1u << 1)) != 0;
+        /*AVX2 还需要操作系统保存 YMM 寄存器*/
+        auto osxsave = (r1[2] & (1u << 27)) != 0;
+        auto avx = (r1[2] & (1u << 28)) != 0;
+        avx2 = osxsave && avx && (xgetbv0() & 0x6) == 0x6 && (r7[1] & (1u << 5)) != 0;
+#endif
+    }
+
+#ifdef BU_ARCH_X64
+    static void cpuid(unsigned int leaf, unsigned int r[4]) {
+#ifdef _MSC_VER
+        int regs[4];
+        __cpuidex(regs, static_cast<int>(leaf), 0);
+        for (int i = 0; i < 4; ++i)
+            r[i] = static_cast<unsigned int>(regs[i]);
+#else
+        __cpuid_count(leaf, 0, r[0], r[1], r[2], r[3]);
+#endif
+    }
+
+    static unsigned long long xgetbv0() {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        unsigned int lo, hi;
+        __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+    }
+#endif
+};
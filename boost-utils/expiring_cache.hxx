@@ -0,0 +1,499 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月22日  10:05:31
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: expiring_cache.hxx
+//  描述: 分片的 LRU/TTL 缓存，过期由时间轮按桶增量清理，支持单飞加载
+// **************************************************************************/
+#pragma once
+
+#include "timing_wheel.hxx"
+#include "types.hxx"
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief 缓存参数
+ */
+struct expiring_cache_options {
+    /**
+     * \brief 分片数
+     */
+    size_t                      shards = 16;
+    /**
+     * \brief 每个分片的容量，超出时淘汰最久未用的条目
+     */
+    size_t                      shard_capacity = 4096;
+    /**
+     * \brief 默认存活时间，为0表示不过期
+     */
+    std::chrono::milliseconds   ttl = std::chrono::seconds(60);
+    /**
+     * \brief 过期时间的精度，也是 attach 到定时器时的清理周期
+     */
+    std::chrono::milliseconds   tick = std::chrono::milliseconds(100);
+};
+
+/**
+ * \brief 分片的过期缓存
+ *
+ * 键按哈希分到各分片，每个分片一把锁、一个哈希表、一条 LRU 链表和一个时间轮。
+ * 条目嵌入时间轮节点，按过期刻度挂在时间轮的槽上；purge_expired 只推进时间轮，
+ * 处理到期的槽，不扫描整个表。可以 attach 到 forever_timer 周期清理，
+ * 未清理的过期条目在读取时也按未命中处理。
+ *
+ * get_or_compute 对同一个键的并发未命中只加载一次，其余调用者等待结果；
+ * 加载函数在锁外执行，抛出的异常传给所有等待者。加载函数中对同一个键再次调用 get_or_compute
+ * 会抛出 std::logic_error 而不是等待自己；加载期间对该键的 put、erase 与 clear 优先，
+ * 加载结果仍返回给调用者与等待者，但不再写入缓存。
+ * \tparam _Key 键类型
+ * \tparam _Value 值类型，需可复制
+ * \tparam _Hash 哈希函数
+ * \tparam _Pred 键比较函数
+ */
+template<class _Key, class _Value, class _Hash = boost::hash<_Key>, class _Pred = std::equal_to<_Key>>
+class expiring_cache final : boost::noncopyable {
+public:
+    /**
+     * \brief 互斥量定义
+     */
+    using _Mutex = boost::mutex;
+    /**
+     * \brief 时钟定义
+     */
+    using _Clock = std::chrono::steady_clock;
+
+    /**
+     * \brief 统计信息
+     */
+    struct stats {
+        ulong64 hits{ 0 };
+        ulong64 misses{ 0 };
+        /**
+         * \brief 超出容量淘汰的条目数
+         */
+        ulong64 evictions{ 0 };
+        /**
+         * \brief 到期删除的条目数
+         */
+        ulong64 expirations{ 0 };
+        /**
+         * \brief get_or_compute 调用加载函数的次数
+         */
+        ulong64 loads{ 0 };
+        /**
+         * \brief get_or_compute 等待他人加载结果的次数
+         */
+        ulong64 coalesced{ 0 };
+        /**
+         * \brief 当前条目数
+         */
+        ulong64 size{ 0 };
+    };
+
+    /**
+     * \brief 构造
+     * \param opts 参数
+     */
+    explicit expiring_cache(const expiring_cache_options &opts = expiring_cache_options())
+        : options(opts)
+        , origin(_Clock::now())
+    {
+        if (options.shards == 0)
+            options.shards = 1;
+        if (options.shard_capacity == 0)
+            options.shard_capacity = 1;
+        if (options.tick.count() <= 0)
+            options.tick = std::chrono::milliseconds(1);
+        shards.reserve(options.shards);
+        for (size_t i = 0; i < options.shards; ++i)
+            shards.emplace_back(new _Shard);
+    }
+
+    /**
+     * \brief 查找
+     * \param key 键
+     * \param out 命中时写入值
+     * \return 命中返回true
+     */
+    bool    get(const _Key &key, _Value &out)
+    {
+        auto &s = shard_of(key);
+        _Mutex::scoped_lock lock(s.mu);
+        auto e = lookup(s, key);
+        if (!e)
+            return false;
+        out = e->value;
+        return true;
+    }
+
+    /**
+     * \brief 写入，使用默认存活时间
+     */
+    void    put(const _Key &key, const _Value &value)
+    {
+        put(key, value, options.ttl);
+    }
+
+    /**
+     * \brief 写入
+     * \param key 键
+     * \param value 值
+     * \param ttl 存活时间，为0表示不过期
+     */
+    template<class _Rep, class _Period>
+    void    put(const _Key &key, const _Value &value, std::chrono::duration<_Rep, _Period> ttl)
+    {
+        auto &s = shard_of(key);
+        _Mutex::scoped_lock lock(s.mu);
+        supersede(s, key);
+        store(s, key, value, std::chrono::duration_cast<_Clock::duration>(ttl));
+    }
+
+    /**
+     * \brief 删除
+     * \return 键存在返回true
+     */
+    bool    erase(const _Key &key)
+    {
+        auto &s = shard_of(key);
+        _Mutex::scoped_lock lock(s.mu);
+        supersede(s, key);
+        auto it = s.map.find(key);
+        if (it == s.map.end())
+            return false;
+        remove(s, it->second);
+        return true;
+    }
+
+    /**
+     * \brief 查找，未命中时调用 loader 加载并写入，同一个键的并发加载只执行一次
+     * \param key 键
+     * \param loader 加载函数，签名为 _Value()
+     * \return 值
+     */
+    template<class _Loader>
+    _Value  get_or_compute(const _Key &key, _Loader &&loader)
+    {
+        return get_or_compute(key, std::forward<_Loader>(loader), options.ttl);
+    }
+
+    /**
+     * \brief 查找，未命中时调用 loader 加载并以 ttl 写入
+     * \param key 键
+     * \param loader 加载函数，签名为 _Value()
+     * \param ttl 存活时间，为0表示不过期
+     * \return 值
+     */
+    template<class _Loader, class _Rep, class _Period>
+    _Value  get_or_compute(const _Key &key, _Loader &&loader, std::chrono::duration<_Rep, _Period> ttl)
+    {
+        auto &s = shard_of(key);
+        _Mutex::scoped_lock lock(s.mu);
+        auto e = lookup(s, key);
+        if (e)
+            return e->value;
+
+        auto it = s.flights.find(key);
+        if (it != s.flights.end()) {
+            auto flight = it->second;
+            if (flight->owner == std::this_thread::get_id())
+                throw std::logic_error("expiring_cache: loader re-entered get_or_compute for the same key");
+            ++s.counters.coalesced;
+            while (!flight->done)
+                flight->cond.wait(lock);
+            if (flight->error)
+                std::rethrow_exception(flight->error);
+            return *flight->value;
+        }
+
+        auto flight = std::make_shared<_Flight>();
+        flight->owner = std::this_thread::get_id();
+        s.flights.emplace(key, flight);
+        ++s.counters.loads;
+        lock.unlock();
+        try {
+            flight->value = loader();
+        }
+        catch (...) {
+            flight->error = std::current_exception();
+        }
+        lock.lock();
+        if (!flight->error && !flight->superseded)
+            store(s, key, *flight->value, std::chrono::duration_cast<_Clock::duration>(ttl));
+        flight->done = true;
+        s.flights.erase(key);
+        flight->cond.notify_all();
+        if (flight->error)
+            std::rethrow_exception(flight->error);
+        return *flight->value;
+    }
+
+    /**
+     * \brief 删除已到期的条目，只处理到期的时间轮槽
+     * \return 删除的条目数
+     */
+    size_t  purge_expired()
+    {
+        auto now_tick = tick_of(_Clock::now());
+        size_t purged = 0;
+        for (auto &sp : shards) {
+            auto &s = *sp;
+            _Mutex::scoped_lock lock(s.mu);
+            if (s.wheel.empty() || s.wheel.next_expiry() > now_tick)
+                continue;
+            s.wheel.advance(now_tick, [&](timer_node &n) {
+                ++s.counters.expirations;
+                ++purged;
+                remove(s, static_cast<_Entry &>(n));
+            });
+        }
+        return purged;
+    }
+
+    /**
+     * \brief 在定时器上按 tick 周期调用 purge_expired
+     * \tparam _Timer 定时器类型，例如 forever_timer
+     * \param timer 定时器
+     * \return 定时器的任务句柄，本对象析构前需先取消
+     */
+    template<class _Timer>
+    typename _Timer::handle attach(_Timer &timer)
+    {
+        return timer.add_doing(options.tick, [this] { purge_expired(); });
+    }
+
+    /**
+     * \brief 清空
+     */
+    void    clear()
+    {
+        for (auto &sp : shards) {
+            auto &s = *sp;
+            _Mutex::scoped_lock lock(s.mu);
+            for (auto &f : s.flights)
+                f.second->superseded = true;
+            while (s.lru_head)
+                remove(s, *s.lru_head);
+        }
+    }
+
+    /**
+     * \brief 条目数
+     */
+    size_t  size() const
+    {
+        size_t n = 0;
+        for (auto &sp : shards) {
+            _Mutex::scoped_lock lock(sp->mu);
+            n += sp->map.size();
+        }
+        return n;
+    }
+
+    /**
+     * \brief 获取统计信息，各分片依次加锁汇总
+     */
+    stats   get_stats() const
+    {
+        stats total;
+        for (auto &sp : shards) {
+            _Mutex::scoped_lock lock(sp->mu);
+            auto &c = sp->counters;
+            total.hits += c.hits;
+            total.misses += c.misses;
+            total.evictions += c.evictions;
+            total.expirations += c.expirations;
+            total.loads += c.loads;
+            total.coalesced += c.coalesced;
+            total.size += sp->map.size();
+        }
+        return total;
+    }
+
+private:
+
+    /**
+     * \brief 条目，嵌入时间轮节点与 LRU 链表
+     */
+    struct _Entry : timer_node {
+        explicit _Entry(const _Value &v) : value(v) {}
+
+        _Value          value;
+        /**
+         * \brief 指向哈希表中的键，删除时使用
+         */
+        const _Key      *key{ nullptr };
+        _Entry          *lru_prev{ nullptr };
+        _Entry          *lru_next{ nullptr };
+    };
+
+    /**
+     * \brief 一次进行中的加载
+     */
+    struct _Flight {
+        boost::condition_variable   cond;
+        /**
+         * \brief 执行加载的线程
+         */
+        std::thread::id             owner;
+        bool                        done{ false };
+        /**
+         * \brief 加载期间该键被 put、erase 或 clear，结果不再写入
+         */
+        bool                        superseded{ false };
+        boost::optional<_Value>     value;
+        std::exception_ptr          error;
+    };
+
+    struct _Shard : boost::noncopyable {
+        mutable _Mutex  mu;
+        std::unordered_map<_Key, _Entry, _Hash, _Pred>  map;
+        timing_wheel    wheel;
+        /**
+         * \brief LRU 链表，头部为最近使用
+         */
+        _Entry          *lru_head{ nullptr };
+        _Entry          *lru_tail{ nullptr };
+        std::unordered_map<_Key, std::shared_ptr<_Flight>, _Hash, _Pred> flights;
+        stats           counters;
+    };
+
+    _Shard &shard_of(const _Key &key)
+    {
+        auto h = static_cast<qword>(_Hash()(key));
+        /*与哈希表自身的取模错开，避免分片内的桶分布变差*/
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return *shards[h % shards.size()];
+    }
+
+    /**
+     * \brief 该键有进行中的加载时标记其结果作废，需持有锁
+     */
+    static void supersede(_Shard &s, const _Key &key)
+    {
+        if (s.flights.empty())
+            return;
+        auto it = s.flights.find(key);
+        if (it != s.flights.end())
+            it->second->superseded = true;
+    }
+
+    /**
+     * \brief 查找并计数，命中时移到 LRU 头部，已过期的条目删除后按未命中处理，需持有锁
+     */
+    _Entry *lookup(_Shard &s, const _Key &key)
+    {
+        auto it = s.map.find(key);
+        if (it == s.map.end()) {
+            ++s.counters.misses;
+            return nullptr;
+        }
+        auto &e = it->second;
+        if (e.armed() && e.expire <= tick_of(_Clock::now())) {
+            ++s.counters.expirations;
+            ++s.counters.misses;
+            remove(s, e);
+            return nullptr;
+        }
+        ++s.counters.hits;
+        lru_unlink(s, e);
+        lru_push_front(s, e);
+        return &e;
+    }
+
+    /**
+     * \brief 写入或覆盖，超出容量时淘汰 LRU 尾部，需持有锁
+     */
+    void    store(_Shard &s, const _Key &key, const _Value &value, _Clock::duration ttl)
+    {
+        auto it = s.map.find(key);
+        if (it != s.map.end()) {
+            it->second.value = value;
+            lru_unlink(s, it->second);
+        }
+        else {
+            it = s.map.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(value)).first;
+            it->second.key = &it->first;
+        }
+        auto &e = it->second;
+        lru_push_front(s, e);
+        if (ttl.count() > 0)
+            s.wheel.schedule(e, deadline_tick(_Clock::now() + ttl));
+        else
+            s.wheel.cancel(e);
+
+        while (s.map.size() > options.shard_capacity) {
+            ++s.counters.evictions;
+            remove(s, *s.lru_tail);
+        }
+    }
+
+    /**
+     * \brief 从时间轮、LRU 链表与哈希表中删除，需持有锁
+     */
+    void    remove(_Shard &s, _Entry &e)
+    {
+        s.wheel.cancel(e);
+        lru_unlink(s, e);
+        s.map.erase(*e.key);
+    }
+
+    static void lru_push_front(_Shard &s, _Entry &e)
+    {
+        e.lru_prev = nullptr;
+        e.lru_next = s.lru_head;
+        if (s.lru_head)
+            s.lru_head->lru_prev = &e;
+        else
+            s.lru_tail = &e;
+        s.lru_head = &e;
+    }
+
+    static void lru_unlink(_Shard &s, _Entry &e)
+    {
+        if (e.lru_prev)
+            e.lru_prev->lru_next = e.lru_next;
+        else
+            s.lru_head = e.lru_next;
+        if (e.lru_next)
+            e.lru_next->lru_prev = e.lru_prev;
+        else
+            s.lru_tail = e.lru_prev;
+        e.lru_prev = e.lru_next = nullptr;
+    }
+
+    qword   tick_of(_Clock::time_point tp) const
+    {
+        return tp <= origin ? 0 : static_cast<qword>((tp - origin) / options.tick);
+    }
+
+    /**
+     * \brief 过期刻度向上取整，保证不早于存活时间删除
+     */
+    qword   deadline_tick(_Clock::time_point tp) const
+    {
+        auto tick = std::chrono::duration_cast<_Clock::duration>(options.tick);
+        return tp <= origin ? 0 : static_cast<qword>((tp - origin + tick - _Clock::duration(1)) / tick);
+    }
+
+    expiring_cache_options  options;
+    _Clock::time_point      origin;
+    std::vector<std::unique_ptr<_Shard>>    shards;
+};
@@ -8,16 +8,109 @@
 // **************************************************************************/
 #pragma once
 
-#include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/bind.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "timer_stats.hxx"
+#include "timing_wheel.hxx"
 #include "types.hxx"
 
+/**
+ * \brief 定时任务的策略
+ */
+namespace timer_policy {
+    /**
+     * \brief 错过整周期时的追赶策略，本次迟到的触发总会执行一次
+     */
+    enum class catch_up {
+        skip,       //丢弃错过的周期，下一次仍落在原来的时间网格上
+        burst,      //错过几次补几次，连续执行直到追上
+        coalesce    //合并为一次，并以当前时间为起点重新计时
+    };
+
+    /**
+     * \brief 到期时上一次回调仍在执行的处理策略
+     */
+    enum class overrun {
+        skip,       //跳过本次，计入 skipped()
+        queue       //排队，上一次结束后立即再执行一次，计入 queued()；最多排队一次，其余计入 skipped()
+    };
+}
+
+/**
+ * \brief 基于 asio steady_timer 的驱动，在 io_service 线程上唤醒
+ *
+ * 驱动只负责在给定的绝对时间唤醒一次，重复设定时以最后一次为准。
+ */
+class asio_timer_driver final : boost::noncopyable {
+public:
+    using _IoService = boost::asio::io_service;
+    using _Clock = std::chrono::steady_clock;
+
+    explicit asio_timer_driver(_IoService &io_service) : timer(io_service) {}
+
+    /**
+     * \brief 设置唤醒回调，构造后调用一次
+     */
+    void    open(const boost::function<void()> &on_expire) { expire = on_expire; }
+
+    /**
+     * \brief 设定唤醒时间
+     */
+    void    arm(_Clock::time_point when)
+    {
+        timer.expires_at(when);
+        timer.async_wait(boost::bind(&asio_timer_driver::on_wait, this, _1));
+    }
+
+    void    cancel()
+    {
+        ERRCODE ec;
+        timer.cancel(ec);
+    }
+
+private:
+    void    on_wait(const ERRCODE &ec)
+    {
+        if (!ec)
+            expire();
+    }
+
+    boost::asio::steady_timer   timer;
+    boost::function<void()>     expire;
+};
+
 /**
  * \brief 多任务循环定时器
+ *
+ * 任务挂在分层时间轮上，加入、删除与推进都是 O(1)；只用一个驱动定时器，
+ * 并且只在下一个非空槽到期时唤醒。回调在驱动的线程上、锁外执行。
+ * 驱动默认为 asio_timer_driver，也可以换成 timerfd_driver 等不依赖 io_service 的驱动，
+ * 接口不变。
+ *
+ * 每个任务记录绝对截止时间，下一次截止时间由上一次截止时间加周期得到，
+ * 回调耗时与调度延迟不会累积成漂移；错过整周期时按 catch_up 策略处理。
+ *
+ * add_doing 返回任务句柄，可以单独取消或推迟某一个任务（例如连接的空闲超时），
+ * 只是在时间轮上摘下重挂，不查找也不分配内存。
+ *
+ * 默认回调在驱动线程上执行；调用 set_pool 后回调投递到线程池，
+ * 定时器线程只做时间轮的记账。同一任务的回调不会重叠执行，
+ * 上一次未结束时本次按 overrun 策略跳过或排队。
+ *
+ * 每次触发记录实际触发时间与截止时间之差、回调耗时，snapshot() 取出直方图、
+ * 计数与时间轮占用，用于在超时被错过之前发现调度线程饱和。
  */
-class   forever_timer
+template<class _Driver = asio_timer_driver>
+class   basic_forever_timer
 {
 public:
 
@@ -26,120 +119,517 @@ public:
      * \brief 回调函数定义
      */
     using _DoingType = boost::function<void()>;
-    /**
-     * \brief 基本函数列表定义，一个multimap，时间为key值，回调为value值
-     */
-    using _FuncListType = std::multimap<uint, _DoingType>;
     /**
      * \brief 互斥量定义
      */
     using _Mutex = boost::mutex;
     /**
-     * \brief 定时器定义
+     * \brief 驱动定义
      */
-    using _DeadlineTimer = boost::asio::deadline_timer;
-
+    using _DriverType = _Driver;
     /**
-     * \brief 调度器定义
+     * \brief 时钟定义，刻度按单调时钟计算
      */
-    using _IoService = boost::asio::io_service;
+    using _Clock = std::chrono::steady_clock;
     /**
      * \brief 定时器状态
      */
     using _Status = enum {started,stoped};
+
+    /**
+     * \brief 追赶策略
+     */
+    using catch_up = timer_policy::catch_up;
+    /**
+     * \brief 回调重叠时的策略
+     */
+    using overrun = timer_policy::overrun;
+protected:
+    struct _Task;
 public:
+
     /**
-     * \brief 从基本调度器构造，构造初始不启动计时器
-     * \param io_service 调度器
+     * \brief 任务句柄，可复制，复制出的句柄指向同一个任务
+     *
+     * 句柄可以在任意线程使用，但不能与所属定时器的析构并发，也不能在其析构之后调用
+     * cancel、reset、active（skipped、fires 不受限制）；任务取消后句柄仍可安全调用，
+     * 此时各操作返回false。
      */
-    explicit forever_timer(_IoService& io_service)
-        : timer(io_service)
+    class handle {
+    public:
+        handle() {}
+
+        /**
+         * \brief 取消任务，O(1)
+         * \return 任务原先在运行返回true
+         */
+        bool    cancel()
+        {
+            auto owner = task ? task->owner.load(std::memory_order_acquire) : nullptr;
+            if (!owner)
+                return false;
+            return owner->cancel_task(*task);
+        }
+
+        /**
+         * \brief 以新的周期从当前时间重新计时，O(1)，不分配内存
+         * \param period 新周期
+         * \return 任务已取消返回false
+         */
+        template<class _Rep, class _Period>
+        bool    reset(std::chrono::duration<_Rep, _Period> period)
+        {
+            auto owner = task ? task->owner.load(std::memory_order_acquire) : nullptr;
+            if (!owner)
+                return false;
+            return owner->reset_task(*task, std::chrono::duration_cast<_Clock::duration>(period));
+        }
+
+        /**
+         * \brief 按原周期从当前时间重新计时，用于有活动时推迟空闲超时
+         * \return 任务已取消返回false
+         */
+        bool    reset()
+        {
+            auto owner = task ? task->owner.load(std::memory_order_acquire) : nullptr;
+            if (!owner)
+                return false;
+            return owner->reset_task(*task, _Clock::duration(0));
+        }
+
+        /**
+         * \brief 任务是否仍在运行
+         */
+        bool    active() const
+        {
+            auto owner = task ? task->owner.load(std::memory_order_acquire) : nullptr;
+            if (!owner)
+                return false;
+            _Mutex::scoped_lock lock(owner->mu);
+            return task->self != nullptr;
+        }
+
+        /**
+         * \brief 本任务因上一次未结束而跳过的次数
+         */
+        qword   skipped() const
+        {
+            return task ? task->skipped.load(std::memory_order_relaxed) : 0;
+        }
+
+        /**
+         * \brief 本任务回调的执行次数
+         */
+        qword   fires() const
+        {
+            return task ? task->fires.load(std::memory_order_relaxed) : 0;
+        }
+
+        explicit operator bool() const { return task != nullptr; }
+
+    private:
+        friend class basic_forever_timer;
+        explicit handle(std::shared_ptr<_Task> t) : task(std::move(t)) {}
+
+        std::shared_ptr<_Task>  task;
+    };
+
+public:
+    /**
+     * \brief 从驱动需要的上下文构造，例如 asio_timer_driver 的 io_service，构造初始不启动计时器
+     * \param context 驱动的上下文
+     * \param tick 时间轮最低层的刻度，默认1毫秒
+     */
+    template<class _Context, class = typename std::enable_if<std::is_constructible<_Driver, _Context &>::value>::type>
+    explicit basic_forever_timer(_Context &context,
+        std::chrono::microseconds tick = std::chrono::milliseconds(1))
+        : tick_len(tick.count() > 0 ? _Clock::duration(tick) : _Clock::duration(std::chrono::microseconds(1)))
+        , origin(_Clock::now())
+        , driver(context)
+    {
+        driver.open(boost::bind(&basic_forever_timer::handler, this));
+    }
+
+    /**
+     * \brief 用不需要上下文的驱动构造，例如 timerfd_driver
+     * \param tick 时间轮最低层的刻度，默认1毫秒
+     */
+    explicit basic_forever_timer(std::chrono::microseconds tick = std::chrono::milliseconds(1))
+        : tick_len(tick.count() > 0 ? _Clock::duration(tick) : _Clock::duration(std::chrono::microseconds(1)))
+        , origin(_Clock::now())
+    {
+        driver.open(boost::bind(&basic_forever_timer::handler, this));
+    }
+
+    ~basic_forever_timer()
     {
+        _Mutex::scoped_lock lock(mu);
+        driver.cancel();
+        /*断开句柄与任务的联系，句柄持有的任务由句柄释放*/
+        while (tasks)
+            unregister(*tasks);
     }
 
-    void    add_doing(uint sec, const _DoingType &d)
+    /**
+     * \brief 加入循环任务
+     * \param period 周期，精度为刻度长度，例如 std::chrono::milliseconds(250)
+     * \param d 回调
+     * \param policy 追赶策略
+     * \param guard 上一次回调未结束时的处理策略
+     * \return 任务句柄
+     */
+    template<class _Rep, class _Period>
+    handle  add_doing(std::chrono::duration<_Rep, _Period> period, const _DoingType &d,
+        catch_up policy = catch_up::skip, overrun guard = overrun::skip)
     {
+        auto p = clamp_period(std::chrono::duration_cast<_Clock::duration>(period));
+        auto task = std::make_shared<_Task>();
+        task->period = p;
+        task->policy = policy;
+        task->guard = guard;
+        task->doing = d;
+        task->owner.store(this, std::memory_order_relaxed);
+        task->stats = stats;
+
         _Mutex::scoped_lock lock(mu);
-        doing_list.insert({ sec,d });
-        /*当调度器处于停止状态，加入任务自动开始计时器*/
-        if (status == stoped)
-            start();
+        ++task_count;
+        task->self = task;
+        task->reg_next = tasks;
+        if (tasks)
+            tasks->reg_prev = task.get();
+        tasks = task.get();
+        task->deadline = _Clock::now() + p;
+        wheel.schedule(*task, deadline_tick(task->deadline));
+        /*当调度器处于停止状态或新任务更早到期，重新设定定时器*/
+        arm();
+        return handle(std::move(task));
     }
 
     /**
-     * \brief 删除计时，当前只能将时间内的任务全部删除，无法删除单任务
-     * \param sec 要删除的定时时间
+     * \brief 加入循环任务
+     * \param sec 周期（秒）
+     * \param d 回调
+     * \return 任务句柄
+     */
+    handle  add_doing(uint sec, const _DoingType &d)
+    {
+        return add_doing(std::chrono::seconds(sec), d);
+    }
+
+    /**
+     * \brief 删除计时，将该周期的任务全部删除，单个任务用句柄的 cancel()
+     * \param period 要删除的定时周期
+     */
+    template<class _Rep, class _Period>
+    void    del_doing(std::chrono::duration<_Rep, _Period> period)
+    {
+        auto p = clamp_period(std::chrono::duration_cast<_Clock::duration>(period));
+        _Mutex::scoped_lock lock(mu);
+        for (auto t = tasks; t; ) {
+            auto next = t->reg_next;
+            if (t->period == p)
+                unregister(*t);
+            t = next;
+        }
+    }
+
+    /**
+     * \brief 删除计时，将该周期的任务全部删除
+     * \param sec 要删除的定时时间（秒）
      */
     void    del_doing(uint sec)
     {
+        del_doing(std::chrono::seconds(sec));
+    }
+
+    /**
+     * \brief 回调改为投递到线程池执行，需在加入任务前调用
+     * \tparam _Pool 线程池类型，例如 boost::threadpool::fifo_pool
+     * \param pool 线程池，生命期不短于本定时器
+     */
+    template<class _Pool>
+    void    set_pool(_Pool &pool)
+    {
+        executor = [&pool](const _DoingType &job) { pool.schedule(job); };
+    }
+
+    /**
+     * \brief 因上一次回调未结束而跳过的总次数
+     */
+    qword   skipped() const { return skipped_count.load(std::memory_order_relaxed); }
+
+    /**
+     * \brief 因上一次回调未结束而排队的总次数
+     */
+    qword   queued() const { return queued_count.load(std::memory_order_relaxed); }
+
+    /**
+     * \brief 唤醒时已错过的刻度总数，这些刻度在一次推进中批量处理
+     */
+    qword   late_ticks() const { return late_count.load(std::memory_order_relaxed); }
+
+    /**
+     * \brief 取驱动，用于查询驱动自身的状态，例如 timerfd_driver::failure()
+     */
+    const _Driver &get_driver() const { return driver; }
+
+    /**
+     * \brief 取统计快照，直方图与计数不加锁读取，时间轮的量在锁内读取
+     */
+    timer_snapshot  snapshot() const
+    {
+        timer_snapshot snap;
+        snap.lateness = stats->lateness.snapshot();
+        snap.duration = stats->duration.snapshot();
+        snap.fires = stats->fires.load(std::memory_order_relaxed);
+        snap.skipped = skipped();
+        snap.queued = queued();
+        snap.late_ticks = late_ticks();
         _Mutex::scoped_lock lock(mu);
-        doing_list.erase(sec);
+        snap.registered = task_count;
+        snap.armed = wheel.size();
+        for (uint l = 0; l < timing_wheel::levels; ++l)
+            snap.occupancy[l] = wheel.occupancy(l);
+        return snap;
     }
 
 protected:
 
     /**
-     * \brief 开始定时器
+     * \brief 任务，嵌入时间轮节点
+     */
+    struct _Task : timer_node {
+        _Clock::duration    period{ 0 };
+        /**
+         * \brief 本次的绝对截止时间
+         */
+        _Clock::time_point  deadline;
+        catch_up            policy{ catch_up::skip };
+        overrun             guard{ overrun::skip };
+        _DoingType          doing;
+        /**
+         * \brief 未完成的执行次数（正在执行的加排队的，最多为2），非0表示正在执行
+         */
+        std::atomic<uint>   runs{ 0 };
+        std::atomic<qword>  skipped{ 0 };
+        std::atomic<qword>  fires{ 0 };
+        /**
+         * \brief 所属定时器的统计，定时器析构后仍然有效
+         */
+        std::shared_ptr<timer_stats>    stats;
+        /**
+         * \brief 所属的定时器，取消或定时器析构后为空；在锁内写入，句柄在锁外读取
+         */
+        std::atomic<basic_forever_timer *>  owner{ nullptr };
+        /**
+         * \brief 运行期间对自身的引用，取消时释放
+         */
+        std::shared_ptr<_Task>  self;
+        /**
+         * \brief 任务登记链表
+         */
+        _Task               *reg_prev{ nullptr };
+        _Task               *reg_next{ nullptr };
+    };
+
+    /**
+     * \brief 取消任务
      */
-    void    start()
+    bool    cancel_task(_Task &task)
     {
-        auto sec = doing_list.begin()->first;
-        timer.expires_from_now(boost::posix_time::seconds(sec));
-        timer.async_wait(boost::bind(&forever_timer::handler, this, sec, _1));
-        status = started;
+        _Mutex::scoped_lock lock(mu);
+        if (!task.self)
+            return false;
+        unregister(task);
+        return true;
     }
 
     /**
-     * \brief 从链表中取得下一个定时
-     * \param sec 上一个定时
-     * \return 
+     * \brief 从当前时间重新计时
+     * \param period 新周期，为0时沿用原周期
      */
-    _FuncListType::_Pairii           wait_next(uint sec)
+    bool    reset_task(_Task &task, _Clock::duration period)
     {
+        auto now = _Clock::now();
         _Mutex::scoped_lock lock(mu);
+        if (!task.self)
+            return false;
+        if (period.count() != 0)
+            task.period = clamp_period(period);
+        task.deadline = now + task.period;
+        wheel.schedule(task, deadline_tick(task.deadline));
+        /*推迟时原先设定的唤醒落空后再按时间轮重设，提前时立即重设*/
+        arm();
+        return true;
+    }
 
-        if (doing_list.empty())
-        {
+    /**
+     * \brief 从时间轮与登记链表上摘下任务并释放自身引用，需持有锁
+     */
+    void    unregister(_Task &task)
+    {
+        wheel.cancel(task);
+        if (task.reg_prev)
+            task.reg_prev->reg_next = task.reg_next;
+        else
+            tasks = task.reg_next;
+        if (task.reg_next)
+            task.reg_next->reg_prev = task.reg_prev;
+        task.reg_prev = task.reg_next = nullptr;
+        task.owner.store(nullptr, std::memory_order_release);
+        --task_count;
+        /*最后释放，可能析构任务本身*/
+        std::shared_ptr<_Task> self;
+        self.swap(task.self);
+    }
+
+    /**
+     * \brief 按时间轮的下一个非空刻度设定定时器，已设定的时间不晚于它时不动
+     */
+    void    arm()
+    {
+        auto next = wheel.next_expiry();
+        if (next == timing_wheel::never()) {
             status = stoped;
-            return{ doing_list.end(),doing_list.end() };
+            return;
         }
+        if (status == started && next >= armed_tick)
+            return;
+        armed_tick = next;
+        status = started;
+        driver.arm(origin + tick_len * static_cast<_Clock::rep>(next));
+    }
 
-        _FuncListType::iterator next;
-        uint next_sec = 0;
+    /**
+     * \brief 驱动唤醒时调用，推进时间轮，锁外执行或投递到期的回调
+     */
+    void                handler()
+    {
+        std::vector<std::shared_ptr<_Task>> fired;
+        {
+            _Mutex::scoped_lock lock(mu);
+            status = stoped;
+            auto now = _Clock::now();
+            auto now_tick = tick_of(now);
+            if (now_tick > armed_tick)
+                late_count.fetch_add(now_tick - armed_tick, std::memory_order_relaxed);
+            wheel.advance(now_tick, [&](timer_node &n) {
+                auto &task = static_cast<_Task &>(n);
+                stats->lateness.record(now - task.deadline);
+                fired.push_back(task.self);
+                reschedule(task, now);
+            });
+            arm();
+        }
 
-        auto it = doing_list.equal_range(sec);
-        next = doing_list.upper_bound(sec) == doing_list.end() ? doing_list.begin() : doing_list.upper_bound(sec);
+        for (auto &task : fired)
+            dispatch(task);
+    }
 
-        next_sec = next == doing_list.begin() ? next->first : next->first - it.first->first;
-        timer.expires_from_now(boost::posix_time::seconds(next_sec));
-        timer.async_wait(boost::bind(&forever_timer::handler, this, next->first, _1));
+    /**
+     * \brief 按 overrun 策略占用任务，成功后在线程池或当前线程执行
+     * \param task 任务
+     */
+    void        dispatch(const std::shared_ptr<_Task> &task)
+    {
+        if (task->guard == overrun::skip) {
+            uint idle = 0;
+            if (!task->runs.compare_exchange_strong(idle, 1, std::memory_order_acquire)) {
+                task->skipped.fetch_add(1, std::memory_order_relaxed);
+                skipped_count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        else {
+            /*最多排队一次，已有排队时本次计为跳过*/
+            auto cur = task->runs.load(std::memory_order_relaxed);
+            do {
+                if (cur >= 2) {
+                    task->skipped.fetch_add(1, std::memory_order_relaxed);
+                    skipped_count.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            } while (!task->runs.compare_exchange_weak(cur, cur + 1, std::memory_order_acquire, std::memory_order_relaxed));
+            if (cur != 0) {
+                /*由正在执行的一方结束后接着执行*/
+                queued_count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
 
-        return it;
+        if (executor)
+            executor(boost::bind(&basic_forever_timer::run, task));
+        else
+            run(task);
     }
 
     /**
-     * \brief 定时器内置handler
-     * \param sec 当前运行到的时间
-     * \param ec 错误代码
+     * \brief 执行回调，有排队时接着执行一次，任务已取消时丢弃排队
+     * \param task 任务，任务被取消或定时器析构后仍然有效
      */
-    void                handler(uint sec, const ERRCODE &ec)
+    static void run(const std::shared_ptr<_Task> &task)
     {
-        if (ec)
-            return;
+        for (;;) {
+            auto start = _Clock::now();
+            task->doing();
+            task->stats->duration.record(_Clock::now() - start);
+            task->stats->fires.fetch_add(1, std::memory_order_relaxed);
+            task->fires.fetch_add(1, std::memory_order_relaxed);
+            if (task->runs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                return;
+            if (!task->owner.load(std::memory_order_acquire)) {
+                task->runs.store(0, std::memory_order_release);
+                return;
+            }
+        }
+    }
 
-        auto cur = wait_next(sec);
+    /**
+     * \brief 从上一次截止时间推算下一次，按策略处理错过的周期
+     * \param task 任务
+     * \param now 本次推进的时间
+     */
+    void        reschedule(_Task &task, _Clock::time_point now)
+    {
+        auto next = task.deadline + task.period;
+        if (next <= now) {
+            switch (task.policy) {
+            case catch_up::skip:
+                next += task.period * ((now - next) / task.period + 1);
+                break;
+            case catch_up::coalesce:
+                next = now + task.period;
+                break;
+            case catch_up::burst:
+                break;
+            }
+        }
+        task.deadline = next;
+        wheel.schedule(task, deadline_tick(next));
+    }
 
-        _Mutex::scoped_lock lock(mu);
-        if (cur == _FuncListType::_Pairii{ doing_list.end(), doing_list.end() })
-            return;
+    /**
+     * \brief 时间所在的刻度（向下取整）
+     */
+    qword       tick_of(_Clock::time_point tp) const
+    {
+        return tp <= origin ? 0 : static_cast<qword>((tp - origin) / tick_len);
+    }
 
-        auto bg = cur.first, ed = cur.second;
+    /**
+     * \brief 截止时间所在的刻度（向上取整），保证不早于截止时间触发
+     */
+    qword       deadline_tick(_Clock::time_point tp) const
+    {
+        return tp <= origin ? 0 : static_cast<qword>((tp - origin + tick_len - _Clock::duration(1)) / tick_len);
+    }
 
-        while (bg != ed)
-        {
-            bg->second();
-            ++bg;
-        }
+    /**
+     * \brief 周期不短于一个刻度
+     */
+    _Clock::duration    clamp_period(_Clock::duration period) const
+    {
+        return period < tick_len ? tick_len : period;
     }
 
 private:
@@ -151,16 +641,49 @@ private:
     /**
      * \brief 互斥量，避免多线程访问
      */
-    _Mutex              mu;
+    mutable _Mutex      mu;
+    /**
+     * \brief 时间轮
+     */
+    timing_wheel        wheel;
+    /**
+     * \brief 刻度长度与零点
+     */
+    _Clock::duration    tick_len;
+    _Clock::time_point  origin;
     /**
-     * \brief 主timer
+     * \brief 定时器已设定的刻度
      */
-    _DeadlineTimer      timer;
+    qword               armed_tick{ 0 };
     /**
-     * \brief 任务列表
+     * \brief 已登记的任务链表头
      */
-    _FuncListType       doing_list;
+    _Task               *tasks{ nullptr };
+    /**
+     * \brief 回调的执行者，为空时在定时器线程上执行
+     */
+    boost::function<void(const _DoingType &)>   executor;
+    /**
+     * \brief 跳过与排队的计数
+     */
+    std::atomic<qword>  skipped_count{ 0 };
+    std::atomic<qword>  queued_count{ 0 };
+    std::atomic<qword>  late_count{ 0 };
+    /**
+     * \brief 已登记的任务数
+     */
+    size_t              task_count{ 0 };
+    /**
+     * \brief 延迟、耗时与执行次数
+     */
+    std::shared_ptr<timer_stats>    stats{ std::make_shared<timer_stats>() };
+    /**
+     * \brief 驱动放在最后，析构时先于其他成员停止
+     */
+    _Driver             driver;
 };
 
-
-
+/**
+ * \brief 由 asio io_service 驱动的循环定时器
+ */
+using forever_timer = basic_forever_timer<>;
@@ -0,0 +1,269 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月20日  09:41:18
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: frame_decoder.hxx
+//  描述: 长度前缀分帧的增量解码器，适用于 TCP 字节流
+// **************************************************************************/
+#pragma once
+
+#include "ustring_view.hxx"
+#include <boost/system/error_code.hpp>
+#include <algorithm>
+#include <cstring>
+
+/**
+ * \brief 长度字段格式，定长格式均为大端序
+ */
+enum class frame_length_type
+{
+    u16,
+    u32,
+    varint  //LEB128，每字节低7位有效，最高位表示后面还有字节
+};
+
+/**
+ * \brief 分帧参数
+ */
+struct frame_options {
+    /**
+     * \brief 长度字段格式
+     */
+    frame_length_type   length_type{ frame_length_type::u32 };
+    /**
+     * \brief 单帧最大长度（不含长度字段），超出视为错误
+     */
+    size_t              max_frame{ 16 * 1024 * 1024 };
+};
+
+/**
+ * \brief 增量分帧解码器
+ *
+ * 可以输入任意大小的数据块，跨块的状态保存在解码器中。完全落在本次输入块内的帧
+ * 以指向输入块的视图直接回调，不做复制；跨块的帧在内部缓冲拼接完整后回调。
+ * 回调得到的视图只在回调期间有效。
+ */
+class frame_decoder final {
+public:
+    /**
+     * \brief 构造
+     * \param opts 分帧参数
+     */
+    explicit frame_decoder(const frame_options &opts = frame_options()) : options(opts) {}
+
+    /**
+     * \brief 输入一块数据，回调其中所有完整的帧
+     * \tparam _Func 回调类型，签名为 void(ustring_view frame)
+     * \param chunk 数据块
+     * \param on_frame 回调
+     * \param ec 错误代码：帧超长为 message_size，长度字段非法为 bad_message，出错后解码器需要 reset()
+     * \return 本次回调的帧数
+     */
+    template<class _Func>
+    size_t feed(ustring_view chunk, _Func &&on_frame, ERRCODE &ec) {
+        ec = error;
+        if (ec)
+            return 0;
+        auto p = chunk.data();
+        auto n = chunk.size();
+        size_t frames = 0;
+
+        while (n > 0 || (in_body && body_len == 0)) {
+            if (!in_body) {
+                if (!read_header(p, n))
+                    break;
+                if (error) {
+                    ec = error;
+                    return frames;
+                }
+            }
+            /*整帧都在本块内，直接回调视图*/
+            if (pending.empty() && n >= body_len) {
+                on_frame(ustring_view(p, body_len));
+                p += body_len;
+                n -= body_len;
+                in_body = false;
+                ++frames;
+                continue;
+            }
+            auto take = std::min(n, body_len - pending.size());
+            if (pending.capacity() < body_len)
+                pending.reserve(body_len);
+            pending.append(p, take);
+            p += take;
+            n -= take;
+            if (pending.size() < body_len)
+                break;
+            on_frame(make_view(pending));
+            pending.clear();
+            in_body = false;
+            ++frames;
+        }
+        return frames;
+    }
+
+    /**
+     * \brief 重置状态，丢弃未完成的帧并清除错误
+     */
+    void reset() {
+        hdr_len = 0;
+        in_body = false;
+        body_len = 0;
+        pending.clear();
+        error.clear();
+    }
+
+    /**
+     * \brief 内部缓存的未完成字节数
+     * \return 字节数
+     */
+    size_t buffered() const { return hdr_len + pending.size(); }
+
+    /**
+     * \brief 按分帧格式写出一帧
+     * \param out 输出
+     * \param payload 帧内容
+     * \param opts 分帧参数
+     */
+    static void append_frame(ustring &out, ustring_view payload, const frame_options &opts = frame_options()) {
+        auto len = payload.size();
+        switch (opts.length_type) {
+        case frame_length_type::u16:
+            out.append_short(static_cast<ushort>(len));
+            break;
+        case frame_length_type::u32:
+            out.append_int(static_cast<uint>(len));
+            break;
+        case frame_length_type::varint:
+            while (len >= 0x80) {
+                out.push_back(static_cast<uchar>(len | 0x80));
+                len >>= 7;
+            }
+            out.push_back(static_cast<uchar>(len));
+            break;
+        }
+        out.append(payload.data(), payload.size());
+    }
+
+private:
+
+    /**
+     * \brief 长度字段最大字节数
+     */
+    size_t header_max() const {
+        switch (options.length_type) {
+        case frame_length_type::u16: return 2;
+        case frame_length_type::u32: return 4;
+        default: return 10;
+        }
+    }
+
+    /**
+     * \brief 解析长度字段
+     * \return 1 完整，0 还需要更多字节，-1 非法
+     */
+    int parse_header(const uchar *p, size_t n, size_t &used, qword &len) const {
+        switch (options.length_type) {
+        case frame_length_type::u16:
+            if (n < 2)
+                return 0;
+            len = (static_cast<qword>(p[0]) << 8) | p[1];
+            used = 2;
+            return 1;
+        case frame_length_type::u32:
+            if (n < 4)
+                return 0;
+            len = (static_cast<qword>(p[0]) << 24) | (static_cast<qword>(p[1]) << 16)
+                | (static_cast<qword>(p[2]) << 8) | p[3];
+            used = 4;
+            return 1;
+        default:
+            len = 0;
+            for (size_t i = 0; i < n && i < 10; ++i) {
+                /*第10字节只剩最高1位，更大的值或继续位都超出64位*/
+                if (i == 9 && p[i] > 1)
+                    return -1;
+                len |= static_cast<qword>(p[i] & 0x7F) << (7 * i);
+                if ((p[i] & 0x80) == 0) {
+                    used = i + 1;
+                    return 1;
+                }
+            }
+            return n >= 10 ? -1 : 0;
+        }
+    }
+
+    /**
+     * \brief 读取长度字段，成功后进入帧体状态
+     * \return 数据不足返回false
+     */
+    bool read_header(const uchar *&p, size_t &n) {
+        size_t used = 0;
+        qword len = 0;
+        int r;
+        if (hdr_len == 0) {
+            r = parse_header(p, n, used, len);
+            if (r == 0) {
+                std::memcpy(hdr, p, n);
+                hdr_len = n;
+                p += n;
+                n = 0;
+                return false;
+            }
+            if (r > 0) {
+                p += used;
+                n -= used;
+            }
+        }
+        else {
+            /*长度字段被拆在两块中，逐字节补齐*/
+            r = 0;
+            while (r == 0 && n > 0 && hdr_len < header_max()) {
+                hdr[hdr_len++] = *p++;
+                --n;
+                r = parse_header(hdr, hdr_len, used, len);
+            }
+            if (r == 0 && hdr_len < header_max())
+                return false;
+            hdr_len = 0;
+        }
+        if (r <= 0) {
+            error = boost::system::errc::make_error_code(boost::system::errc::bad_message);
+            return true;
+        }
+        if (len > options.max_frame) {
+            error = boost::system::errc::make_error_code(boost::system::errc::message_size);
+            return true;
+        }
+        body_len = static_cast<size_t>(len);
+        in_body = true;
+        return true;
+    }
+
+    /**
+     * \brief 分帧参数
+     */
+    frame_options   options;
+    /**
+     * \brief 不完整的长度字段
+     */
+    uchar           hdr[10];
+    size_t          hdr_len{ 0 };
+    /**
+     * \brief 是否正在读取帧体
+     */
+    bool            in_body{ false };
+    /**
+     * \brief 当前帧体长度
+     */
+    size_t          body_len{ 0 };
+    /**
+     * \brief 跨块帧的拼接缓冲
+     */
+    ustring         pending;
+    /**
+     * \brief 错误状态
+     */
+    ERRCODE         error;
+};
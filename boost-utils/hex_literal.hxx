@@ -0,0 +1,132 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月20日  15:02:47
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: hex_literal.hxx
+//  描述: 编译期十六进制字节常量
+// **************************************************************************/
+#pragma once
+
+#include "ustring_view.hxx"
+#include <stdexcept>
+#include <utility>
+
+/*
+ * 用法：
+ *     constexpr auto magic = hex_bytes("CAFEBABE");   // 所有编译器，包括 VS2015
+ *     auto tag = "DEADBEEF"_hex;                       // 仅 GCC/Clang，定义了 BU_HAS_HEX_LITERAL
+ * 需要跨平台编译的代码使用 hex_bytes，或用 BU_HAS_HEX_LITERAL 判断后再使用 _hex。
+ */
+
+/**
+ * \brief 编译期生成的定长字节数组，可作为 constexpr 常量
+ * \tparam N 字节数
+ */
+template<size_t N>
+struct hex_literal {
+    uchar   bytes[N];
+
+    constexpr size_t size() const { return N; }
+    const uchar *data() const { return bytes; }
+
+    constexpr uchar operator[](size_t i) const { return bytes[i]; }
+
+    operator ustring_view() const { return ustring_view(bytes, N); }
+
+    /**
+     * \brief 转换为字节串
+     */
+    ustring to_ustring() const { return ustring(bytes, bytes + N); }
+};
+
+namespace hex_literal_detail {
+
+/**
+ * \brief 单个十六进制字符的值，非法字符在常量求值中抛出异常，从而编译失败
+ */
+constexpr uchar nibble(char c) {
+    return (c >= '0' && c <= '9') ? static_cast<uchar>(c - '0')
+        : (c >= 'a' && c <= 'f') ? static_cast<uchar>(c - 'a' + 10)
+        : (c >= 'A' && c <= 'F') ? static_cast<uchar>(c - 'A' + 10)
+        : throw std::invalid_argument("invalid hex digit");
+}
+
+constexpr uchar byte_at(const char *s, size_t i) {
+    return static_cast<uchar>((nibble(s[2 * i]) << 4) | nibble(s[2 * i + 1]));
+}
+
+template<size_t... _I>
+constexpr hex_literal<sizeof...(_I)> decode(const char *s, std::index_sequence<_I...>) {
+    return hex_literal<sizeof...(_I)>{ { byte_at(s, _I)... } };
+}
+
+constexpr bool is_hex(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+constexpr bool all_hex(const char *s, size_t n) {
+    return n == 0 || (is_hex(*s) && all_hex(s + 1, n - 1));
+}
+
+template<char... _Cs>
+struct chars {
+    static constexpr char value[] = { _Cs..., 0 };
+};
+
+template<char... _Cs>
+constexpr char chars<_Cs...>::value[];
+
+}
+
+/**
+ * \brief 将十六进制字符串解码为字节数组
+ *
+ * 在 constexpr 上下文中使用时于编译期完成校验与解码，例如
+ * constexpr auto magic = hex_bytes("CAFEBABE");
+ * 位数为奇数时编译失败，含非十六进制字符时常量求值失败。
+ * \param s 十六进制字符串，不含分隔符
+ * \return 字节数组
+ */
+template<size_t N>
+constexpr hex_literal<(N - 1) / 2> hex_bytes(const char (&s)[N]) {
+    static_assert(N > 1 && (N - 1) % 2 == 0, "hex literal must have a non-zero even number of digits");
+    return hex_literal_detail::decode(s, std::make_index_sequence<(N - 1) / 2>());
+}
+
+#if defined(__GNUC__)
+#define BU_HAS_HEX_LITERAL  1
+/**
+ * \brief 十六进制字面量，例如 "DEADBEEF"_hex
+ *
+ * 使用 GNU 的字符串字面量运算符模板，字符在模板参数中，
+ * 任何上下文中使用，位数或字符非法都会编译失败。MSVC 不支持该扩展，请用 hex_bytes。
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Wgnu-string-literal-operator-template"
+#endif
+template<class _Char, _Char... _Cs>
+constexpr hex_literal<sizeof...(_Cs) / 2> operator"" _hex() {
+    static_assert(sizeof...(_Cs) > 0 && sizeof...(_Cs) % 2 == 0,
+        "hex literal must have a non-zero even number of digits");
+    static_assert(hex_literal_detail::all_hex(hex_literal_detail::chars<static_cast<char>(_Cs)...>::value, sizeof...(_Cs)),
+        "hex literal contains a non-hex digit");
+    return hex_literal_detail::decode(hex_literal_detail::chars<static_cast<char>(_Cs)...>::value,
+        std::make_index_sequence<sizeof...(_Cs) / 2>());
+}
+#pragma GCC diagnostic pop
+#endif
+
+/**
+ * \brief 将字节常量追加到字节串尾部，一次 memcpy
+ * \param s 字节串
+ * \param h 字节常量
+ * \return 当前字节串
+ */
+template<class _Alloc, size_t N>
+inline basic_ustring<_Alloc> &operator<<(basic_ustring<_Alloc> &s, const hex_literal<N> &h) {
+    s.append(h.bytes, N);
+    return s;
+}
@@ -0,0 +1,202 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月20日  14:08:36
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: hexdump.hxx
+//  描述: xxd 风格的十六进制转储，流式写出，不生成中间字符串
+// **************************************************************************/
+#pragma once
+
+#include "ustring_view.hxx"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+
+/**
+ * \brief 转储参数
+ */
+struct hexdump_options {
+    /**
+     * \brief 最多输出的字节数，0 表示不限；超出时保留首尾各一半，中间省略
+     */
+    size_t  max_bytes{ 0 };
+    /**
+     * \brief 第一个字节对应的偏移，转储大缓冲中的一段时使用
+     */
+    qword   base_offset{ 0 };
+    /**
+     * \brief 十六进制是否大写
+     */
+    bool    upper{ false };
+};
+
+/**
+ * \brief 十六进制转储
+ *
+ * 每行 16 字节，格式与 xxd 相同：
+ * 00000010: 4865 6c6c 6f2c 2077 6f72 6c64 210a 0001  Hello, world!...
+ * 逐行格式化到栈上的小缓冲，满了就交给输出端，整个过程不分配内存。
+ */
+class hexdump_writer final {
+public:
+    enum : size_t {
+        line_bytes = 16,    //每行字节数
+        line_chars = 68     //每行最大字符数（含换行）
+    };
+
+    /**
+     * \brief 转储到任意输出端
+     * \tparam _Sink 输出端类型，签名为 void(const char *p, size_t n)
+     * \param data 数据
+     * \param opts 转储参数
+     * \param sink 输出端
+     */
+    template<class _Sink>
+    static void write(ustring_view data, const hexdump_options &opts, _Sink &&sink) {
+        char buffer[line_chars * 8];
+        size_t used = 0;
+        auto flush = [&]() {
+            if (used)
+                sink(static_cast<const char *>(buffer), used);
+            used = 0;
+        };
+
+        auto n = data.size();
+        size_t head = n, tail_from = n;
+        if (opts.max_bytes && n > opts.max_bytes) {
+            /*首尾按整行保留，尾部按原始偏移对齐*/
+            auto half = opts.max_bytes / 2;
+            head = (half + line_bytes - 1) / line_bytes * line_bytes;
+            tail_from = (n - half) / line_bytes * line_bytes;
+            if (tail_from <= head)
+                head = tail_from = n;
+        }
+
+        for (size_t off = 0; off < n;) {
+            if (off == head) {
+                flush();
+                char note[64];
+                auto len = snprintf(note, sizeof(note), "... %llu bytes omitted ...\n",
+                    static_cast<unsigned long long>(tail_from - head));
+                sink(static_cast<const char *>(note), static_cast<size_t>(len));
+                off = tail_from;
+                continue;
+            }
+            auto count = std::min<size_t>(line_bytes, n - off);
+            if (used + line_chars > sizeof(buffer))
+                flush();
+            used += format_line(buffer + used, data.data() + off, count, opts.base_offset + off, opts.upper);
+            off += count;
+        }
+        flush();
+    }
+
+    /**
+     * \brief 转储到输出流
+     * \param o 输出流
+     * \param data 数据
+     * \param opts 转储参数
+     */
+    static void write(std::ostream &o, ustring_view data, const hexdump_options &opts = hexdump_options()) {
+        write(data, opts, [&o](const char *p, size_t n) {
+            o.write(p, static_cast<std::streamsize>(n));
+        });
+    }
+
+    /**
+     * \brief 转储到调用方提供的定长缓冲，空间不够时截断
+     * \param out 缓冲
+     * \param cap 缓冲大小，结果总以 '\0' 结尾
+     * \param data 数据
+     * \param opts 转储参数
+     * \return 写入的字符数（不含结尾的 '\0'）
+     */
+    static size_t write(char *out, size_t cap, ustring_view data, const hexdump_options &opts = hexdump_options()) {
+        if (cap == 0)
+            return 0;
+        size_t used = 0;
+        write(data, opts, [&](const char *p, size_t n) {
+            auto take = std::min(n, cap - 1 - used);
+            memcpy(out + used, p, take);
+            used += take;
+        });
+        out[used] = 0;
+        return used;
+    }
+
+private:
+
+    /**
+     * \brief 格式化一行
+     * \return 写入的字符数
+     */
+    static size_t format_line(char *out, const uchar *p, size_t count, qword offset, bool upper) {
+        static const char upper_digits[] = "0123456789ABCDEF";
+        static const char lower_digits[] = "0123456789abcdef";
+        auto digits = upper ? upper_digits : lower_digits;
+        auto start = out;
+
+        for (int shift = 28; shift >= 0; shift -= 4)
+            *out++ = digits[(offset >> shift) & 0x0F];
+        *out++ = ':';
+        *out++ = ' ';
+        for (size_t i = 0; i < line_bytes; ++i) {
+            if (i < count) {
+                *out++ = digits[p[i] >> 4];
+                *out++ = digits[p[i] & 0x0F];
+            }
+            else {
+                *out++ = ' ';
+                *out++ = ' ';
+            }
+            if (i & 1)
+                *out++ = ' ';
+        }
+        *out++ = ' ';
+        for (size_t i = 0; i < count; ++i)
+            *out++ = (p[i] >= 0x20 && p[i] < 0x7F) ? static_cast<char>(p[i]) : '.';
+        *out++ = '\n';
+        return static_cast<size_t>(out - start);
+    }
+};
+
+/**
+ * \brief 流操纵符，用于日志等场合：LOG_DEBUG("recv\n" << hexdump(buf, 256))
+ */
+struct hexdump_manip {
+    ustring_view        data;
+    hexdump_options     opts;
+};
+
+/**
+ * \brief 生成转储操纵符，只保存视图，不复制数据
+ * \param data 数据
+ * \param max_bytes 最多输出的字节数，0 表示不限
+ * \return 操纵符
+ */
+inline hexdump_manip hexdump(ustring_view data, size_t max_bytes = 0) {
+    hexdump_manip m;
+    m.data = data;
+    m.opts.max_bytes = max_bytes;
+    return m;
+}
+
+/**
+ * \brief 生成转储操纵符
+ * \param data 数据
+ * \param opts 转储参数
+ * \return 操纵符
+ */
+inline hexdump_manip hexdump(ustring_view data, const hexdump_options &opts) {
+    hexdump_manip m;
+    m.data = data;
+    m.opts = opts;
+    return m;
+}
+
+inline std::ostream &operator<<(std::ostream &o, const hexdump_manip &m) {
+    hexdump_writer::write(o, m.data, m.opts);
+    return o;
+}
@@ -0,0 +1,439 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月22日  14:37:52
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: binlog.hxx
+//  描述: 延迟格式化的二进制日志：调用线程只记录参数，后台线程格式化后写入 boost.log
+// **************************************************************************/
+#pragma once
+
+#include "logger.hxx"
+#include "../types.hxx"
+#include <boost/current_function.hpp>
+#include <boost/date_time/posix_time/ptime.hpp>
+#include <boost/log/attributes/mutable_constant.hpp>
+#include <boost/log/attributes/named_scope.hpp>
+#include <boost/log/sources/severity_logger.hpp>
+#include <boost/log/utility/string_literal.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief 日志调用点的静态描述，每个调用点一份，常量初始化
+ */
+struct binlog_site {
+    const char                      *fmt;
+    loglevel                        level;
+    boost::log::string_literal      function;
+    boost::log::string_literal      file;
+    unsigned int                    line;
+};
+
+/**
+ * \brief 调用点的作用域名称与类型，与 BOOST_LOG_FUNC() 的取法一致，输出与同步路径相同
+ */
+#if defined(_MSC_VER) || defined(__GNUC__)
+#define BU_LOG_SITE_FUNCTION    __FUNCTION__
+#define BU_LOG_SITE_SCOPE       boost::log::attributes::named_scope_entry::general
+#else
+#define BU_LOG_SITE_FUNCTION    BOOST_CURRENT_FUNCTION
+#define BU_LOG_SITE_SCOPE       boost::log::attributes::named_scope_entry::function
+#endif
+
+namespace binlog_detail {
+
+    /**
+     * \brief 参数的预处理：算术与枚举原样记录，字符串记录内容，其他指针记录地址，其他类型在调用线程转为字符串
+     */
+    template<class T, class = void>
+    struct codec {
+        static std::string prepare(const T &v) {
+            std::ostringstream os;
+            os << v;
+            return os.str();
+        }
+    };
+
+    template<class T>
+    struct codec<T, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type> {
+        static const T &prepare(const T &v) { return v; }
+    };
+
+    template<class T>
+    struct codec<T *, typename std::enable_if<!std::is_function<T>::value &&
+        !std::is_same<typename std::remove_cv<T>::type, char>::value>::type> {
+        static const void *prepare(const T *v) { return v; }
+    };
+
+    template<>
+    struct codec<const char *> {
+        static const char *prepare(const char *v) { return v ? v : "(null)"; }
+    };
+
+    template<>
+    struct codec<char *> {
+        static const char *prepare(const char *v) { return v ? v : "(null)"; }
+    };
+
+    template<>
+    struct codec<std::string> {
+        static const std::string &prepare(const std::string &v) { return v; }
+    };
+
+    /**
+     * \brief 预处理后参数的编码，字符串为4字节长度加内容
+     */
+    template<class T>
+    struct wire {
+        using value_type = T;
+        static size_t size(const T &) { return sizeof(T); }
+        static void put(uchar *&p, const T &v) {
+            std::memcpy(p, &v, sizeof(T));
+            p += sizeof(T);
+        }
+        static T get(const uchar *&p) {
+            T v;
+            std::memcpy(&v, p, sizeof(T));
+            p += sizeof(T);
+            return v;
+        }
+    };
+
+    struct string_wire {
+        using value_type = std::string;
+        static size_t size(const char *s, size_t n) { (void)s; return sizeof(uint) + n; }
+        static void put(uchar *&p, const char *s, size_t n) {
+            auto len = static_cast<uint>(n);
+            std::memcpy(p, &len, sizeof(len));
+            std::memcpy(p + sizeof(len), s, n);
+            p += sizeof(len) + n;
+        }
+        static std::string get(const uchar *&p) {
+            uint len;
+            std::memcpy(&len, p, sizeof(len));
+            std::string s(reinterpret_cast<const char *>(p + sizeof(len)), len);
+            p += sizeof(len) + len;
+            return s;
+        }
+    };
+
+    template<>
+    struct wire<const char *> : string_wire {
+        static size_t size(const char *s) { return string_wire::size(s, std::strlen(s)); }
+        static void put(uchar *&p, const char *s) { string_wire::put(p, s, std::strlen(s)); }
+    };
+
+    template<>
+    struct wire<std::string> : string_wire {
+        static size_t size(const std::string &s) { return string_wire::size(s.data(), s.size()); }
+        static void put(uchar *&p, const std::string &s) { string_wire::put(p, s.data(), s.size()); }
+    };
+
+    template<class T>
+    using prepared_t = typename std::decay<decltype(codec<typename std::decay<T>::type>::prepare(std::declval<const T &>()))>::type;
+
+    /**
+     * \brief 按格式描述与解码出的参数格式化
+     */
+    template<class _Tuple, size_t... I>
+    inline std::string apply_format(const char *fmt, const _Tuple &args, std::index_sequence<I...>)
+    {
+        std::string msg;
+        log_format::format_to(msg, fmt, std::get<I>(args)...);
+        return msg;
+    }
+
+    /**
+     * \brief 解码函数，每种参数组合实例化一份，指针随记录写入环形缓冲
+     */
+    template<class... Ps>
+    std::string decode(const binlog_site &site, const uchar *p)
+    {
+        /*花括号初始化保证从左到右求值*/
+        std::tuple<typename wire<Ps>::value_type...> args{ wire<Ps>::get(p)... };
+        (void)p;
+        return apply_format(site.fmt, args, std::index_sequence_for<Ps...>());
+    }
+}
+
+/**
+ * \brief 延迟格式化的二进制日志
+ *
+ * 每个线程一个单生产者单消费者的字节环形缓冲，调用线程写入调用点描述、时间戳与参数的原始字节，
+ * 不格式化、不加锁、不分配内存（算术、字符串与指针以外的参数除外，它们在调用线程先转为字符串）；
+ * 后台线程轮询各线程的缓冲，解码、格式化后以记录时的时间戳与调用点作用域写入现有的 boost.log 输出；
+ * 登记缓冲时调用线程带有 Uptime 属性的，按记录时间补上 Uptime。调用点外层的命名作用域不会记录。
+ *
+ * 未启动、缓冲已满或单条记录过大时退回同步格式化，不丢日志；同步输出前先等待本线程缓冲中的记录取空，
+ * 保持同一线程的日志顺序。
+ * 后台线程须在静态对象析构前停止，析构函数不会停止它；init_logger 登记的 atexit 回调会调用 logger::shutdown。
+ * 定义 BU_LOG_DEFERRED 时 LOG_*_F 使用本路径，格式字符串需为字面量。
+ */
+class binlog final : boost::noncopyable {
+public:
+    /**
+     * \brief 互斥量定义
+     */
+    using _Mutex = boost::mutex;
+    /**
+     * \brief 解码函数定义
+     */
+    using _Decoder = std::string(*)(const binlog_site &, const uchar *);
+
+    enum : size_t {
+        /**
+         * \brief 每个线程的缓冲大小
+         */
+        ring_bytes = 64 * 1024,
+        /**
+         * \brief 单条记录的最大字节数，超过时同步输出
+         */
+        max_record = ring_bytes / 4
+    };
+
+    /**
+     * \brief 获取单例
+     */
+    static binlog &instance()
+    {
+        static binlog _inst;
+        return _inst;
+    }
+
+    /**
+     * \brief 启动后台线程，重复调用无影响
+     */
+    void    start();
+
+    /**
+     * \brief 输出所有缓冲中的记录后停止后台线程
+     */
+    void    stop();
+
+    /**
+     * \brief 记录一条日志
+     * \param site 调用点描述
+     * \param args 参数
+     */
+    template<class... Args>
+    static void write(const binlog_site &site, const Args &...args)
+    {
+        write_prepared<binlog_detail::prepared_t<Args>...>(site,
+            binlog_detail::codec<typename std::decay<Args>::type>::prepare(args)...);
+    }
+
+    /**
+     * \brief 因缓冲已满或记录过大而同步输出的条数
+     */
+    qword   overflows() const { return overflow_count.load(std::memory_order_relaxed); }
+
+private:
+
+    /**
+     * \brief 记录头，按8字节对齐，site 为空表示缓冲尾部的填充
+     */
+    struct _Header {
+        const binlog_site   *site;
+        _Decoder            decode;
+        qword               wall_ns;
+        uint                size;
+        uint                reserved;
+    };
+
+    /**
+     * \brief 单生产者单消费者的字节环形缓冲，记录不跨越缓冲尾部
+     */
+    struct _Ring : boost::noncopyable {
+        std::atomic<qword>  head{ 0 };
+        char                pad0[64 - sizeof(std::atomic<qword>)];
+        std::atomic<qword>  tail{ 0 };
+        char                pad1[64 - sizeof(std::atomic<qword>)];
+        /**
+         * \brief 所属线程已退出，取空后移除
+         */
+        std::atomic<bool>   closed{ false };
+        /**
+         * \brief 所属线程正在写入记录，stop() 等待其清零后再做最后一次取空
+         */
+        std::atomic<bool>   writing{ false };
+        /**
+         * \brief 所属线程带有 Uptime 属性时，计时起点的墙上时间
+         */
+        bool                has_uptime{ false };
+        qword               uptime_origin_ns{ 0 };
+        qword               storage[ring_bytes / sizeof(qword)];
+
+        uchar *data() { return reinterpret_cast<uchar *>(storage); }
+
+        /**
+         * \brief 生产者预留 n 字节（8的倍数），空间不足返回空
+         */
+        uchar *reserve(size_t n, qword &next)
+        {
+            auto pos = head.load(std::memory_order_relaxed);
+            auto off = static_cast<size_t>(pos & (ring_bytes - 1));
+            auto contiguous = ring_bytes - off;
+            auto need = n <= contiguous ? n : contiguous + n;
+            if (ring_bytes - (pos - tail.load(std::memory_order_acquire)) < need)
+                return nullptr;
+            if (n > contiguous) {
+                reinterpret_cast<_Header *>(data() + off)->site = nullptr;
+                off = 0;
+            }
+            next = pos + need;
+            return data() + off;
+        }
+    };
+
+    /**
+     * \brief 线程退出时标记缓冲关闭
+     */
+    struct _Holder {
+        std::shared_ptr<_Ring>  ring;
+        ~_Holder()
+        {
+            if (ring)
+                ring->closed.store(true, std::memory_order_release);
+        }
+    };
+
+    binlog();
+
+    /**
+     * \brief 写入缓冲的结果
+     */
+    enum class _Push {
+        pushed,
+        full,
+        stopped
+    };
+
+    template<class... Ps>
+    static void write_prepared(const binlog_site &site, const Ps &...args)
+    {
+        auto &self = instance();
+        if (self.running.load(std::memory_order_acquire)) {
+            auto r = self.push(site, args...);
+            if (r == _Push::pushed)
+                return;
+            if (r == _Push::full) {
+                self.overflow_count.fetch_add(1, std::memory_order_relaxed);
+                self.wait_drained();
+            }
+        }
+        emit_sync(site, binlog_detail::apply_format(site.fmt, std::forward_as_tuple(args...), std::index_sequence_for<Ps...>()));
+    }
+
+    /**
+     * \brief 将记录写入本线程的缓冲
+     *
+     * 先置 writing 再确认仍在运行，与 stop() 先清 running 再等待 writing 配对（均为顺序一致），
+     * 两边至少有一方看到对方的写入：要么这里退回同步输出，要么 stop() 等到记录发布后再取空。
+     */
+    template<class... Ps>
+    _Push   push(const binlog_site &site, const Ps &...args)
+    {
+        size_t bytes = sizeof(_Header);
+        using swallow = int[];
+        (void)swallow{ 0, (bytes += binlog_detail::wire<Ps>::size(args), 0)... };
+        bytes = (bytes + 7) & ~size_t(7);
+        if (bytes > max_record)
+            return _Push::full;
+        auto ring = local_ring();
+        ring->writing.store(true);
+        if (!running.load()) {
+            ring->writing.store(false, std::memory_order_release);
+            return _Push::stopped;
+        }
+        qword next;
+        auto p = ring->reserve(bytes, next);
+        if (p) {
+            auto hdr = reinterpret_cast<_Header *>(p);
+            hdr->site = &site;
+            hdr->decode = &binlog_detail::decode<Ps...>;
+            hdr->wall_ns = wall_clock_ns();
+            hdr->size = static_cast<uint>(bytes);
+            p += sizeof(_Header);
+            (void)swallow{ 0, (binlog_detail::wire<Ps>::put(p, args), 0)... };
+            ring->head.store(next, std::memory_order_release);
+        }
+        ring->writing.store(false, std::memory_order_release);
+        return p ? _Push::pushed : _Push::full;
+    }
+
+    /**
+     * \brief 本线程的缓冲，首次使用时登记
+     */
+    _Ring  *local_ring()
+    {
+        static thread_local _Holder holder;
+        if (!holder.ring)
+            holder.ring = attach();
+        return holder.ring.get();
+    }
+
+    /**
+     * \brief 为调用线程创建并登记缓冲
+     */
+    std::shared_ptr<_Ring> attach();
+
+    /**
+     * \brief 等待本线程缓冲中已写入的记录被后台线程取走
+     */
+    void    wait_drained()
+    {
+        auto ring = local_ring();
+        while (ring->tail.load(std::memory_order_acquire) != ring->head.load(std::memory_order_relaxed) &&
+               running.load(std::memory_order_acquire))
+            boost::this_thread::yield();
+    }
+
+    static qword wall_clock_ns()
+    {
+        return static_cast<qword>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    /**
+     * \brief 在调用线程上直接输出
+     */
+    static void emit_sync(const binlog_site &site, const std::string &msg);
+
+    /**
+     * \brief 后台线程，轮询各缓冲
+     */
+    void    run();
+
+    /**
+     * \brief 取出一个缓冲中的全部记录
+     * \return 输出的条数
+     */
+    size_t  drain(_Ring &ring);
+
+    /**
+     * \brief 后台线程输出用的 logger，记录时的时间戳作为源属性覆盖全局的 TimeStamp；
+     * lg_uptime 另带记录时的 Uptime，用于来自带 Uptime 属性线程的记录
+     */
+    boost::log::sources::severity_logger<loglevel>                  lg;
+    boost::log::sources::severity_logger<loglevel>                  lg_uptime;
+    boost::log::attributes::mutable_constant<boost::posix_time::ptime> timestamp{ boost::posix_time::ptime{} };
+    boost::log::attributes::mutable_constant<boost::posix_time::time_duration> uptime{ boost::posix_time::time_duration{} };
+    std::atomic<bool>   running{ false };
+    std::atomic<bool>   stopping{ false };
+    std::atomic<qword>  overflow_count{ 0 };
+    _Mutex              mu;
+    std::vector<std::shared_ptr<_Ring>> rings;
+    boost::thread       worker;
+};
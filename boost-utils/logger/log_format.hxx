@@ -0,0 +1,760 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月22日  17:12:26
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: log_format.hxx
+//  描述: 日志格式化：编译期检查格式串与参数，运行期单遍写入可复用的缓冲
+// **************************************************************************/
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace log_format_detail {
+
+    /**
+     * \brief 参数类别，编译期检查与运行期输出共用
+     */
+    enum class arg_kind {
+        integer,
+        boolean,
+        character,
+        floating,
+        string,
+        pointer,
+        enumeration,
+        other
+    };
+
+    template<class T>
+    struct kind_of {
+        static constexpr arg_kind value =
+            std::is_same<T, bool>::value ? arg_kind::boolean :
+            (std::is_same<T, char>::value || std::is_same<T, signed char>::value || std::is_same<T, unsigned char>::value) ? arg_kind::character :
+            std::is_integral<T>::value ? arg_kind::integer :
+            std::is_floating_point<T>::value ? arg_kind::floating :
+            (std::is_same<T, const char *>::value || std::is_same<T, char *>::value || std::is_same<T, std::string>::value) ? arg_kind::string :
+            std::is_pointer<T>::value ? arg_kind::pointer :
+            std::is_enum<T>::value ? arg_kind::enumeration :
+            arg_kind::other;
+    };
+
+    /**
+     * \brief 检查结果
+     */
+    enum check_result : int {
+        ok,
+        too_few_args,
+        too_many_args,
+        bad_type,
+        bad_spec,
+        /*%p 的参数是字符串：同步格式化输出其地址，延迟格式化只记录内容，无法输出地址*/
+        string_pointer
+    };
+
+    template<class... Args>
+    struct type_list {};
+
+    /**
+     * \brief 只用于 decltype 取参数类型，数组与函数退化为指针
+     */
+    template<class... Args>
+    type_list<typename std::decay<Args>::type...> types(const Args &...);
+
+    constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+    constexpr bool is_flag(char c) { return c == '-' || c == '+' || c == ' ' || c == '0' || c == '#'; }
+
+    constexpr bool is_length(char c) { return c == 'h' || c == 'l' || c == 'L' || c == 'q' || c == 'j' || c == 'z' || c == 't'; }
+
+    /**
+     * \brief 转换符是否接受该类别的参数，未知转换符返回 bad_spec
+     */
+    constexpr int accepts(char conv, arg_kind k)
+    {
+        return conv == 's' ? ok :
+            (conv == 'd' || conv == 'i' || conv == 'u') ?
+                (k == arg_kind::integer || k == arg_kind::boolean || k == arg_kind::character || k == arg_kind::enumeration ? ok : bad_type) :
+            (conv == 'x' || conv == 'X' || conv == 'o') ?
+                (k == arg_kind::integer || k == arg_kind::boolean || k == arg_kind::character ? ok : bad_type) :
+            conv == 'c' ?
+                (k == arg_kind::integer || k == arg_kind::character ? ok : bad_type) :
+            (conv == 'f' || conv == 'F' || conv == 'e' || conv == 'E' || conv == 'g' || conv == 'G' || conv == 'a' || conv == 'A') ?
+                (k == arg_kind::floating || k == arg_kind::integer ? ok : bad_type) :
+            conv == 'p' ?
+                (k == arg_kind::pointer ? ok : k == arg_kind::string ? string_pointer : bad_type) :
+            bad_spec;
+    }
+
+    /*以下均为 C++11 constexpr（单个 return 加递归），VS2015 也可在编译期求值*/
+
+    constexpr size_t skip_flags(const char *fmt, size_t i, size_t len)
+    {
+        return i < len && is_flag(fmt[i]) ? skip_flags(fmt, i + 1, len) : i;
+    }
+
+    constexpr size_t skip_digits(const char *fmt, size_t i, size_t len)
+    {
+        return i < len && is_digit(fmt[i]) ? skip_digits(fmt, i + 1, len) : i;
+    }
+
+    constexpr size_t skip_length(const char *fmt, size_t i, size_t len)
+    {
+        return i < len && is_length(fmt[i]) ? skip_length(fmt, i + 1, len) : i;
+    }
+
+    constexpr size_t skip_precision(const char *fmt, size_t i, size_t len)
+    {
+        return i < len && fmt[i] == '.' ? skip_digits(fmt, i + 1, len) : i;
+    }
+
+    /**
+     * \brief 跳过 flags、宽度、精度与长度修饰，返回转换符的位置
+     */
+    constexpr size_t skip_spec(const char *fmt, size_t i, size_t len)
+    {
+        return skip_length(fmt, skip_precision(fmt, skip_digits(fmt, skip_flags(fmt, i, len), len), len), len);
+    }
+
+    constexpr size_t parse_index(const char *fmt, size_t i, size_t end, size_t acc)
+    {
+        return i < end ? parse_index(fmt, i + 1, end, acc * 10 + static_cast<size_t>(fmt[i] - '0')) : acc;
+    }
+
+    /**
+     * \brief 合并检查结果，后面的错误优先于前面的 string_pointer
+     */
+    constexpr int merge(int first, int rest)
+    {
+        return rest != ok ? rest : first;
+    }
+
+    constexpr size_t first_of(size_t a, size_t b, size_t none)
+    {
+        return a != none ? a : b;
+    }
+
+    /**
+     * \brief [lo, hi) 中第一个 %，没有返回 len；二分递归，深度只与长度的对数有关
+     */
+    constexpr size_t find_percent(const char *fmt, size_t lo, size_t hi, size_t len)
+    {
+        return hi <= lo ? len :
+            hi - lo == 1 ? (fmt[lo] == '%' ? lo : len) :
+            first_of(find_percent(fmt, lo, lo + (hi - lo) / 2, len), find_percent(fmt, lo + (hi - lo) / 2, hi, len), len);
+    }
+
+    template<class _List>
+    struct checker;
+
+    /**
+     * \brief 编译期检查格式串
+     *
+     * 支持 printf 风格的 %[flags][width][.precision][length]conv 与 boost::format 的 %N%，
+     * 检查指示符个数与参数个数一致、转换符与参数类别相容。不支持 * 宽度。
+     */
+    template<class... Args>
+    struct checker<type_list<Args...>> {
+        static constexpr size_t count = sizeof...(Args);
+        static constexpr arg_kind kinds[sizeof...(Args) + 1] = { kind_of<Args>::value..., arg_kind::other };
+
+        template<size_t N>
+        static constexpr int check(const char (&fmt)[N])
+        {
+            return scan(fmt, N - 1, 0, 0, false);
+        }
+
+    private:
+        /**
+         * \brief 从 i 起查找下一个指示符，next 为下一个顺序参数
+         */
+        static constexpr int scan(const char *fmt, size_t len, size_t i, size_t next, bool positional)
+        {
+            return directive(fmt, len, find_percent(fmt, i, len, len), next, positional);
+        }
+
+        /**
+         * \brief p 为 % 的位置，等于 len 表示格式串结束
+         */
+        static constexpr int directive(const char *fmt, size_t len, size_t p, size_t next, bool positional)
+        {
+            return p >= len ? (next < count && !positional ? too_many_args : ok) :
+                p + 1 >= len ? bad_spec :
+                fmt[p + 1] == '%' ? scan(fmt, len, p + 2, next, positional) :
+                is_positional(fmt, len, p + 1, skip_digits(fmt, p + 1, len)) ?
+                    positional_arg(fmt, len, skip_digits(fmt, p + 1, len), parse_index(fmt, p + 1, skip_digits(fmt, p + 1, len), 0), next) :
+                conversion(fmt, len, skip_spec(fmt, p + 1, len), next, positional);
+        }
+
+        static constexpr bool is_positional(const char *fmt, size_t len, size_t i, size_t j)
+        {
+            return j > i && j < len && fmt[j] == '%';
+        }
+
+        static constexpr int positional_arg(const char *fmt, size_t len, size_t j, size_t index, size_t next)
+        {
+            return index == 0 || index > count ? too_few_args : scan(fmt, len, j + 1, next, true);
+        }
+
+        static constexpr int conversion(const char *fmt, size_t len, size_t c, size_t next, bool positional)
+        {
+            return c >= len ? bad_spec :
+                next >= count ? too_few_args :
+                accepts(fmt[c], kinds[next]) == string_pointer ? merge(string_pointer, scan(fmt, len, c + 1, next + 1, positional)) :
+                accepts(fmt[c], kinds[next]) != ok ? accepts(fmt[c], kinds[next]) :
+                scan(fmt, len, c + 1, next + 1, positional);
+        }
+    };
+
+    template<class... Args>
+    constexpr size_t checker<type_list<Args...>>::count;
+
+    template<class... Args>
+    constexpr arg_kind checker<type_list<Args...>>::kinds[sizeof...(Args) + 1];
+
+    /**
+     * \brief 运行期解析出的指示符
+     */
+    struct spec {
+        bool    left{ false };
+        bool    plus{ false };
+        bool    space{ false };
+        bool    zero{ false };
+        bool    alt{ false };
+        int     width{ 0 };
+        int     precision{ -1 };
+        char    conv{ 's' };
+    };
+
+    /**
+     * \brief 按宽度补齐后追加，数值补0时0插在符号与前缀之后
+     */
+    inline void pad(std::string &out, const char *s, size_t n, const spec &sp, bool numeric)
+    {
+        auto width = sp.width > 0 ? static_cast<size_t>(sp.width) : 0;
+        if (n >= width) {
+            out.append(s, n);
+            return;
+        }
+        auto fill = width - n;
+        if (sp.left) {
+            out.append(s, n);
+            out.append(fill, ' ');
+        }
+        else if (sp.zero && numeric) {
+            size_t prefix = 0;
+            if (n > 0 && (s[0] == '-' || s[0] == '+' || s[0] == ' '))
+                prefix = 1;
+            if (n >= prefix + 2 && s[prefix] == '0' && (s[prefix + 1] == 'x' || s[prefix + 1] == 'X'))
+                prefix += 2;
+            out.append(s, prefix);
+            out.append(fill, '0');
+            out.append(s + prefix, n - prefix);
+        }
+        else {
+            out.append(fill, ' ');
+            out.append(s, n);
+        }
+    }
+
+    /**
+     * \brief 无符号整数转十进制，从 end 向前写，返回起始位置
+     */
+    inline char *utoa(unsigned long long v, char *end)
+    {
+        static const char pairs[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        while (v >= 100) {
+            auto r = static_cast<size_t>(v % 100) * 2;
+            v /= 100;
+            *--end = pairs[r + 1];
+            *--end = pairs[r];
+        }
+        if (v >= 10) {
+            auto r = static_cast<size_t>(v) * 2;
+            *--end = pairs[r + 1];
+            *--end = pairs[r];
+        }
+        else {
+            *--end = static_cast<char>('0' + v);
+        }
+        return end;
+    }
+
+    /**
+     * \brief 整数输出，精度为最少位数（超过64按64处理），精度为0且值为0时不输出数字，与 printf 一致
+     */
+    inline void write_integer(std::string &out, const spec &sp, unsigned long long mag, bool negative)
+    {
+        char buf[72];
+        auto end = buf + sizeof(buf);
+        auto p = end;
+        auto zero = mag == 0;
+        if (sp.precision != 0 || !zero) {
+            switch (sp.conv) {
+            case 'x': case 'X': {
+                auto digits = sp.conv == 'x' ? "0123456789abcdef" : "0123456789ABCDEF";
+                do {
+                    *--p = digits[mag & 15];
+                    mag >>= 4;
+                } while (mag);
+                break;
+            }
+            case 'o':
+                do {
+                    *--p = static_cast<char>('0' + (mag & 7));
+                    mag >>= 3;
+                } while (mag);
+                break;
+            default:
+                p = utoa(mag, end);
+                break;
+            }
+        }
+        auto precision = sp.precision < 64 ? sp.precision : 64;
+        while (end - p < precision)
+            *--p = '0';
+        switch (sp.conv) {
+        case 'x': case 'X':
+            if (sp.alt && !zero) {
+                *--p = sp.conv;
+                *--p = '0';
+            }
+            break;
+        case 'o':
+            if (sp.alt && (p == end || *p != '0'))
+                *--p = '0';
+            break;
+        default:
+            if (negative)
+                *--p = '-';
+            else if (sp.plus)
+                *--p = '+';
+            else if (sp.space)
+                *--p = ' ';
+            break;
+        }
+        /*指定精度时忽略 0 标志*/
+        pad(out, p, static_cast<size_t>(end - p), sp, sp.precision < 0);
+    }
+
+    template<class T>
+    void write_signed(std::string &out, const spec &sp, T v)
+    {
+        if (sp.conv == 'c') {
+            auto c = static_cast<char>(v);
+            pad(out, &c, 1, sp, false);
+            return;
+        }
+        /*%u、十六进制与八进制按参数本身宽度的无符号值输出，与 printf 一致*/
+        if (sp.conv == 'u' || sp.conv == 'x' || sp.conv == 'X' || sp.conv == 'o') {
+            write_integer(out, sp, static_cast<typename std::make_unsigned<T>::type>(v), false);
+            return;
+        }
+        auto u = static_cast<unsigned long long>(static_cast<long long>(v));
+        write_integer(out, sp, v < 0 ? 0ULL - u : u, v < 0);
+    }
+
+    template<class T>
+    void write_unsigned(std::string &out, const spec &sp, T v)
+    {
+        if (sp.conv == 'c') {
+            auto c = static_cast<char>(v);
+            pad(out, &c, 1, sp, false);
+            return;
+        }
+        write_integer(out, sp, static_cast<unsigned long long>(v), false);
+    }
+
+    template<class T>
+    void write_int(std::string &out, const spec &sp, T v, std::true_type) { write_signed(out, sp, v); }
+
+    template<class T>
+    void write_int(std::string &out, const spec &sp, T v, std::false_type) { write_unsigned(out, sp, v); }
+
+    /**
+     * \brief 用 snprintf 按原指示符输出浮点数，处理 %e %g %a 与 %f 的边界情况
+     */
+    inline void write_float_slow(std::string &out, const spec &sp, double v)
+    {
+        char f[16];
+        size_t n = 0;
+        f[n++] = '%';
+        if (sp.plus)
+            f[n++] = '+';
+        if (sp.space)
+            f[n++] = ' ';
+        if (sp.alt)
+            f[n++] = '#';
+        f[n++] = '.';
+        f[n++] = '*';
+        f[n++] = sp.conv == 's' ? 'g' : sp.conv;
+        f[n] = 0;
+        auto precision = sp.precision >= 0 ? sp.precision : 6;
+        char buf[128];
+        auto len = std::snprintf(buf, sizeof(buf), f, precision, v);
+        if (len < 0)
+            return;
+        if (static_cast<size_t>(len) < sizeof(buf)) {
+            pad(out, buf, static_cast<size_t>(len), sp, std::isfinite(v));
+            return;
+        }
+        std::string big(static_cast<size_t>(len) + 1, '\0');
+        std::snprintf(&big[0], big.size(), f, precision, v);
+        pad(out, big.data(), static_cast<size_t>(len), sp, std::isfinite(v));
+    }
+
+    /**
+     * \brief 浮点数输出，%f 且放大后的值精确可判断舍入时走整数快速路径
+     */
+    inline void write_float(std::string &out, const spec &sp, double v)
+    {
+        static const double scale[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+        auto precision = sp.precision >= 0 ? sp.precision : 6;
+        if ((sp.conv == 'f' || sp.conv == 'F') && !sp.alt && precision <= 9 && std::isfinite(v)) {
+            auto negative = std::signbit(v);
+            auto scaled = (negative ? -v : v) * scale[precision];
+            if (scaled < 9e15) {
+                auto whole = std::floor(scaled);
+                auto frac = scaled - whole;
+                /*接近 .5 时交给 snprintf 做精确舍入*/
+                if (std::fabs(frac - 0.5) > scaled * 4e-16 + 1e-9) {
+                    auto r = static_cast<unsigned long long>(whole) + (frac > 0.5 ? 1 : 0);
+                    auto unit = static_cast<unsigned long long>(scale[precision]);
+                    char buf[48];
+                    auto end = buf + sizeof(buf);
+                    auto p = end;
+                    if (precision > 0) {
+                        auto fp = r % unit;
+                        auto q = utoa(fp, end);
+                        while (end - q < precision)
+                            *--q = '0';
+                        p = q;
+                        *--p = '.';
+                    }
+                    p = utoa(r / unit, p);
+                    if (negative)
+                        *--p = '-';
+                    else if (sp.plus)
+                        *--p = '+';
+                    else if (sp.space)
+                        *--p = ' ';
+                    pad(out, p, static_cast<size_t>(end - p), sp, true);
+                    return;
+                }
+            }
+        }
+        write_float_slow(out, sp, v);
+    }
+
+    inline void write_string(std::string &out, const spec &sp, const char *s, size_t n)
+    {
+        if (sp.precision >= 0 && static_cast<size_t>(sp.precision) < n)
+            n = static_cast<size_t>(sp.precision);
+        pad(out, s, n, sp, false);
+    }
+
+    inline void write_pointer(std::string &out, const spec &sp, const void *p)
+    {
+        if (!p) {
+            pad(out, "0x0", 3, sp, false);
+            return;
+        }
+        spec hex = sp;
+        hex.conv = 'x';
+        hex.alt = true;
+        write_integer(out, hex, static_cast<unsigned long long>(reinterpret_cast<std::uintptr_t>(p)), false);
+    }
+
+    /**
+     * \brief 本线程嵌套格式化的层数，参数的 operator<< 中再次记录日志时大于0
+     */
+    inline size_t &nesting()
+    {
+        static thread_local size_t depth = 0;
+        return depth;
+    }
+
+    /**
+     * \brief 进入一层格式化，析构时退出，level 为进入前的层数
+     */
+    struct nest {
+        size_t  level;
+        nest() : level(nesting()++) {}
+        ~nest() { --nesting(); }
+        nest(const nest &) = delete;
+        nest &operator=(const nest &) = delete;
+    };
+
+    /**
+     * \brief 其他类型经 operator<< 输出，流对象每个线程复用；
+     * operator<< 中再次格式化时改用局部的流，不覆盖外层的内容
+     */
+    template<class T>
+    void write_streamed(std::string &out, const spec &sp, const T &v)
+    {
+        static thread_local std::ostringstream shared;
+        static thread_local bool busy = false;
+        if (busy) {
+            std::ostringstream os;
+            os << v;
+            auto s = os.str();
+            write_string(out, sp, s.data(), s.size());
+            return;
+        }
+        struct _Busy {
+            _Busy() { busy = true; }
+            ~_Busy() { busy = false; }
+        } guard;
+        shared.str(std::string());
+        shared.clear();
+        shared << v;
+        auto s = shared.str();
+        write_string(out, sp, s.data(), s.size());
+    }
+
+    /*各类别的输出*/
+
+    template<class T>
+    void write_value(std::string &out, const spec &sp, const T &v, std::integral_constant<arg_kind, arg_kind::integer>)
+    {
+        if (sp.conv == 'f' || sp.conv == 'F' || sp.conv == 'e' || sp.conv == 'E' ||
+            sp.conv == 'g' || sp.conv == 'G' || sp.conv == 'a' || sp.conv == 'A') {
+            write_float(out, sp, static_cast<double>(v));
+            return;
+        }
+        write_int(out, sp, v, std::is_signed<T>());
+    }
+
+    template<class T>
+    void write_value(std::string &out, const spec &sp, const T &v, std::integral_constant<arg_kind, arg_kind::boolean>)
+    {
+        write_unsigned(out, sp, v ? 1u : 0u);
+    }
+
+    template<class T>
+    void write_value(std::string &out, const spec &sp, const T &v, std::integral_constant<arg_kind, arg_kind::character>)
+    {
+        if (sp.conv == 's' || sp.conv == 'c') {
+            auto c = static_cast<char>(v);
+            pad(out, &c, 1, sp, false);
+        }
+        else {
+            write_int(out, sp, v, std::is_signed<T>());
+        }
+    }
+
+    template<class T>
+    void write_value(std::string &out, const spec &sp, const T &v, std::integral_constant<arg_kind, arg_kind::floating>)
+    {
+        write_float(out, sp, static_cast<double>(v));
+    }
+
+    inline void write_value(std::string &out, const spec &sp, const char *v, std::integral_constant<arg_kind, arg_kind::string>)
+    {
+        if (sp.conv == 'p') {
+            write_pointer(out, sp, v);
+            return;
+        }
+        if (!v)
+            v = "(null)";
+        write_string(out, sp, v, std::strlen(v));
+    }
+
+    inline void write_value(std::string &out, const spec &sp, const std::string &v, std::integral_constant<arg_kind, arg_kind::string>)
+    {
+        if (sp.conv == 'p') {
+            write_pointer(out, sp, v.data());
+            return;
+        }
+        write_string(out, sp, v.data(), v.size());
+    }
+
+    template<class T>
+    void write_value(std::string &out, const spec &sp, const T &v, std::integral_constant<arg_kind, arg_kind::pointer>)
+    {
+        write_pointer(out, sp, static_cast<const void *>(v));
+    }
+
+    template<class T>
+    void write_value(std::string &out, const spec &sp, const T &v, std::integral_constant<arg_kind, arg_kind::enumeration>)
+    {
+        write_streamed(out, sp, v);
+    }
+
+    template<class T>
+    void write_value(std::string &out, const spec &sp, const T &v, std::integral_constant<arg_kind, arg_kind::other>)
+    {
+        write_streamed(out, sp, v);
+    }
+
+    /**
+     * \brief 类型擦除的参数引用，放在栈上的数组中
+     */
+    struct arg_ref {
+        const void  *ptr;
+        void        (*write)(std::string &, const spec &, const void *);
+    };
+
+    template<class T>
+    void write_erased(std::string &out, const spec &sp, const void *p)
+    {
+        using _Decayed = typename std::decay<const T>::type;
+        write_value(out, sp, *static_cast<const T *>(p), std::integral_constant<arg_kind, kind_of<_Decayed>::value>());
+    }
+
+    template<class T>
+    arg_ref make_ref(const T &v)
+    {
+        return arg_ref{ &v, &write_erased<T> };
+    }
+
+    /**
+     * \brief 运行期单遍格式化，参数不足时原样输出指示符，多余的参数忽略
+     */
+    inline void format_impl(std::string &out, const char *fmt, const arg_ref *args, size_t count)
+    {
+        size_t next = 0;
+        auto p = fmt;
+        for (;;) {
+            auto q = std::strchr(p, '%');
+            if (!q) {
+                out.append(p);
+                return;
+            }
+            out.append(p, static_cast<size_t>(q - p));
+            auto start = q++;
+            if (*q == '%') {
+                out.push_back('%');
+                p = q + 1;
+                continue;
+            }
+
+            spec sp;
+            size_t index = count;
+            auto d = q;
+            size_t num = 0;
+            while (is_digit(*d))
+                num = num * 10 + static_cast<size_t>(*d++ - '0');
+            if (d > q && *d == '%') {
+                index = num - 1;
+                q = d + 1;
+            }
+            else {
+                for (; is_flag(*q); ++q) {
+                    switch (*q) {
+                    case '-': sp.left = true; break;
+                    case '+': sp.plus = true; break;
+                    case ' ': sp.space = true; break;
+                    case '0': sp.zero = true; break;
+                    case '#': sp.alt = true; break;
+                    }
+                }
+                for (; is_digit(*q); ++q)
+                    sp.width = sp.width * 10 + (*q - '0');
+                if (*q == '.') {
+                    sp.precision = 0;
+                    for (++q; is_digit(*q); ++q)
+                        sp.precision = sp.precision * 10 + (*q - '0');
+                }
+                while (is_length(*q))
+                    ++q;
+                if (*q == 0) {
+                    out.append(start);
+                    return;
+                }
+                sp.conv = *q++;
+                index = next++;
+            }
+
+            if (index < count)
+                args[index].write(out, sp, args[index].ptr);
+            else
+                out.append(start, static_cast<size_t>(q - start));
+            p = q;
+        }
+    }
+}
+
+/**
+ * \brief 日志格式化
+ *
+ * 格式与 printf 及 boost::format 的 %N% 兼容。LOG_*_F 在编译期用 LOG_FORMAT_CHECK 检查格式串，
+ * 运行期只扫描一遍格式串，整数与常见的 %f 不经过流与 snprintf，结果写入每个线程复用的缓冲。
+ */
+class log_format final {
+public:
+    /**
+     * \brief 追加格式化结果
+     * \param out 目标
+     * \param fmt 格式串
+     * \param args 参数
+     */
+    template<class... Args>
+    static void format_to(std::string &out, const char *fmt, const Args &...args)
+    {
+        const log_format_detail::arg_ref refs[sizeof...(Args) + 1] = { log_format_detail::make_ref(args)..., { nullptr, nullptr } };
+        log_format_detail::format_impl(out, fmt, refs, sizeof...(Args));
+    }
+
+    /**
+     * \brief 格式化到本线程的缓冲，参数的 operator<< 中嵌套调用时使用下一层缓冲
+     * \return 缓冲的引用，下一次在本线程同一层格式化前有效
+     */
+    template<class... Args>
+    static const std::string &format(const char *fmt, const Args &...args)
+    {
+        log_format_detail::nest n;
+        auto &buf = buffer(n.level);
+        buf.clear();
+        format_to(buf, fmt, args...);
+        return buf;
+    }
+
+private:
+    static std::string &buffer(size_t level)
+    {
+        static thread_local std::vector<std::unique_ptr<std::string>> bufs;
+        while (bufs.size() <= level)
+            bufs.emplace_back(new std::string);
+        return *bufs[level];
+    }
+};
+
+/**
+ * \brief 延迟格式化只记录字符串的内容，%p 无法输出字符串的地址，需要时先转为 const void *
+ */
+#ifdef BU_LOG_DEFERRED
+#define BU_LOG_FORMAT_CHECK_POINTER(r) \
+        static_assert((r) != log_format_detail::string_pointer, "log format: %p of a string needs a cast to const void * with BU_LOG_DEFERRED");
+#else
+#define BU_LOG_FORMAT_CHECK_POINTER(r)
+#endif
+
+/**
+ * \brief 编译期检查格式串与参数，fmt 需为字面量；不支持 constexpr 的编译器（VS2013 及更早）上为空
+ */
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define LOG_FORMAT_CHECK(fmt, ...)
+#else
+#define LOG_FORMAT_CHECK(fmt, ...) \
+    { \
+        constexpr int _bu_fmt_check = log_format_detail::checker<decltype(log_format_detail::types(__VA_ARGS__))>::check("" fmt); \
+        static_assert(_bu_fmt_check != log_format_detail::too_few_args, "log format: more directives than arguments"); \
+        static_assert(_bu_fmt_check != log_format_detail::too_many_args, "log format: more arguments than directives"); \
+        static_assert(_bu_fmt_check != log_format_detail::bad_type, "log format: argument type does not match conversion"); \
+        static_assert(_bu_fmt_check != log_format_detail::bad_spec, "log format: unsupported format directive"); \
+        BU_LOG_FORMAT_CHECK_POINTER(_bu_fmt_check) \
+    }
+#endif
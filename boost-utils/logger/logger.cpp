@@ -8,6 +8,8 @@
 // **************************************************************************/
 
 #include "logger.hxx"
+#include "binlog.hxx"
+#include <cstdlib>
 #include <iostream>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/log/support/date_time.hpp>
@@ -27,11 +29,18 @@
 #include <boost/log/utility/setup/console.hpp>
 #include <boost/log/utility/setup/common_attributes.hpp>
 #include <boost/log/attributes/named_scope.hpp>
+#include <boost/log/attributes/mutable_constant.hpp>
+#include <boost/date_time/c_local_time_adjustor.hpp>
 #include <boost/filesystem.hpp>
 
 //Logger 全局 唯一实例
 boost::log::sources::severity_logger_mt<loglevel>   logger::_logger;
 
+//日志分类，全局等级默认全部输出
+std::atomic<int>                                    log_category::_threshold{ 0 };
+std::atomic<log_category *>                         log_category::_head{ nullptr };
+log_category                                        log_category::_root("root");
+
 namespace logging = boost::log;
 namespace attrs = boost::log::attributes;
 namespace src = boost::log::sources;
@@ -111,8 +120,8 @@ void logger::init_logger(const std::string &log_dir, const std::string &file_pre
 
     logging::add_common_attributes();
 
-    file_sink->set_filter(log_level >= static_cast<loglevel>(level));   //文件设定日志等级
-    console_sink->set_filter(log_level >= static_cast<loglevel>(level)); //控制台设定日志等级
+    //日志等级在调用点判断，输出不再过滤，运行期可用 set_level 修改
+    set_level(static_cast<loglevel>(level));
 
     file_sink->set_formatter(formatter);
     console_sink->set_formatter(formatter);
@@ -121,4 +130,187 @@ void logger::init_logger(const std::string &log_dir, const std::string &file_pre
     logging::core::get()->add_global_attribute("Scope", attrs::named_scope());
     logging::core::get()->add_sink(file_sink);
     logging::core::get()->add_sink(console_sink);
-}
\ No newline at end of file
+
+#ifdef BU_LOG_DEFERRED
+    binlog::instance().start();
+#endif
+    //在静态对象析构前停止后台线程并刷新输出
+    static bool registered = (std::atexit(&logger::shutdown), true);
+    (void)registered;
+}
+
+/**
+ * \brief 停止 binlog 后台线程并刷新所有输出
+ */
+void logger::shutdown()
+{
+#ifdef BU_LOG_DEFERRED
+    binlog::instance().stop();
+#endif
+    logging::core::get()->flush();
+}
+
+binlog::binlog()
+{
+    lg.add_attribute("TimeStamp", timestamp);
+    lg_uptime.add_attribute("TimeStamp", timestamp);
+    lg_uptime.add_attribute("Uptime", uptime);
+}
+
+/**
+ * \brief 为调用线程创建并登记缓冲，记下该线程 Uptime 计时的起点
+ * \return 缓冲
+ */
+std::shared_ptr<binlog::_Ring> binlog::attach()
+{
+    auto ring = std::make_shared<_Ring>();
+    auto thread_attrs = logging::core::get()->get_thread_attributes();
+    auto it = thread_attrs.find("Uptime");
+    if (it != thread_attrs.end()) {
+        auto value = it->second.get_value();
+        auto elapsed = value.extract<attrs::timer::value_type>();
+        if (elapsed) {
+            ring->has_uptime = true;
+            ring->uptime_origin_ns = wall_clock_ns() - static_cast<qword>(elapsed.get().total_microseconds()) * 1000;
+        }
+    }
+    _Mutex::scoped_lock lock(mu);
+    rings.push_back(ring);
+    return ring;
+}
+
+/**
+ * \brief 启动后台线程
+ */
+void binlog::start()
+{
+    _Mutex::scoped_lock lock(mu);
+    if (running.load())
+        return;
+    stopping.store(false);
+    /*先在本线程初始化 boost.log 内部的线程局部存储，使其析构晚于 init_logger 登记的 atexit 回调*/
+    {
+        auto rec = lg.open_record(keywords::severity = loglevel::Log_Info);
+        (void)rec;
+    }
+    worker = boost::thread(boost::bind(&binlog::run, this));
+    running.store(true, std::memory_order_release);
+}
+
+/**
+ * \brief 停止后台线程，之后的日志同步输出
+ */
+void binlog::stop()
+{
+    {
+        _Mutex::scoped_lock lock(mu);
+        if (!running.load())
+            return;
+        /*先切回同步输出，后台线程取空缓冲后退出*/
+        running.store(false);
+        stopping.store(true);
+    }
+    worker.join();
+
+    /*等待在 running 变为 false 前进入写入的线程发布记录，再取空*/
+    _Mutex::scoped_lock lock(mu);
+    for (auto &ring : rings) {
+        while (ring->writing.load(std::memory_order_acquire))
+            boost::this_thread::yield();
+        drain(*ring);
+    }
+}
+
+/**
+ * \brief 在调用线程上直接输出，作用域取自调用点
+ * \param site 调用点
+ * \param msg 格式化好的消息
+ */
+void binlog::emit_sync(const binlog_site &site, const std::string &msg)
+{
+    attrs::named_scope::sentry scope(site.function, site.file, site.line, BU_LOG_SITE_SCOPE);
+    BOOST_LOG_SEV(logger::_logger, site.level) << msg;
+}
+
+/**
+ * \brief 后台线程，空闲时休眠1毫秒
+ */
+void binlog::run()
+{
+    for (;;) {
+        std::vector<std::shared_ptr<_Ring>> snapshot;
+        {
+            _Mutex::scoped_lock lock(mu);
+            snapshot = rings;
+        }
+        size_t emitted = 0;
+        for (auto &ring : snapshot)
+            emitted += drain(*ring);
+
+        {
+            /*线程已退出且已取空的缓冲移除*/
+            _Mutex::scoped_lock lock(mu);
+            for (auto it = rings.begin(); it != rings.end(); ) {
+                auto &r = **it;
+                if (r.closed.load(std::memory_order_acquire) &&
+                    r.tail.load(std::memory_order_relaxed) == r.head.load(std::memory_order_acquire))
+                    it = rings.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        if (emitted == 0) {
+            if (stopping.load())
+                return;
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        }
+    }
+}
+
+/**
+ * \brief 取出一个缓冲中的全部记录，以记录时的时间戳与调用点作用域输出
+ * \param ring 缓冲
+ * \return 输出的条数
+ */
+size_t binlog::drain(_Ring &ring)
+{
+    size_t emitted = 0;
+    auto tail = ring.tail.load(std::memory_order_relaxed);
+    auto head = ring.head.load(std::memory_order_acquire);
+    while (tail != head) {
+        auto off = static_cast<size_t>(tail & (ring_bytes - 1));
+        auto hdr = reinterpret_cast<const _Header *>(ring.data() + off);
+        if (!hdr->site) {
+            tail += ring_bytes - off;
+            continue;
+        }
+
+        std::string msg;
+        try {
+            msg = hdr->decode(*hdr->site, ring.data() + off + sizeof(_Header));
+        }
+        catch (const std::exception &e) {
+            msg = std::string(hdr->site->fmt) + " <" + e.what() + ">";
+        }
+        auto utc = boost::posix_time::from_time_t(static_cast<std::time_t>(hdr->wall_ns / 1000000000))
+            + boost::posix_time::microseconds(static_cast<long>(hdr->wall_ns % 1000000000 / 1000));
+        timestamp.set(boost::date_time::c_local_adjustor<boost::posix_time::ptime>::utc_to_local(utc));
+        {
+            attrs::named_scope::sentry scope(hdr->site->function, hdr->site->file, hdr->site->line, BU_LOG_SITE_SCOPE);
+            if (ring.has_uptime) {
+                auto since = hdr->wall_ns > ring.uptime_origin_ns ? hdr->wall_ns - ring.uptime_origin_ns : 0;
+                uptime.set(boost::posix_time::microseconds(static_cast<long>(since / 1000)));
+                BOOST_LOG_SEV(lg_uptime, hdr->site->level) << msg;
+            }
+            else {
+                BOOST_LOG_SEV(lg, hdr->site->level) << msg;
+            }
+        }
+        tail += hdr->size;
+        /*逐条归还空间，生产者不必等整批处理完*/
+        ring.tail.store(tail, std::memory_order_release);
+        ++emitted;
+    }
+    return emitted;
+}
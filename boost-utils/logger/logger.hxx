@@ -11,7 +11,10 @@
 #include <boost/log/sources/severity_logger.hpp>
 #include <boost/log/sources/record_ostream.hpp>
 #include <boost/log/attributes/named_scope.hpp>
-#include <boost/format.hpp>
+#include "log_format.hxx"
+#include <boost/noncopyable.hpp>
+#include <atomic>
+#include <cstring>
 
 
 /**
@@ -68,6 +71,99 @@ inline  bool   operator < (loglevel &l1, loglevel & l2)
     return static_cast<std::size_t>(l1) < static_cast<std::size_t>(l2);
 }
 
+/**
+ * \brief 编译期最低日志等级，低于该等级的调用点在编译期被移除，取值同 loglevel
+ */
+#ifndef BU_LOG_MIN_LEVEL
+#define BU_LOG_MIN_LEVEL    0
+#endif
+
+/**
+ * \brief 日志分类，每个分类可单独设定等级，未设定时使用全局等级
+ *
+ * 分类需为静态存储期，构造时无锁地挂入全局链表，不会移除。
+ * 在源文件中定义分类并重定义 BU_LOG_CATEGORY 后，该文件中的日志宏使用此分类：
+ *     static log_category net_log("net");
+ *     #undef BU_LOG_CATEGORY
+ *     #define BU_LOG_CATEGORY net_log
+ * 等级的读写均为无锁原子操作，可在信号处理函数中调用 set_level。
+ */
+class   log_category    final : boost::noncopyable
+{
+public:
+    explicit log_category(const char *name) : _name(name)
+    {
+        auto head = _head.load(std::memory_order_relaxed);
+        do {
+            _next = head;
+        } while (!_head.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    const char  *name() const { return _name; }
+
+    /**
+     * \brief 该等级的日志是否输出
+     */
+    bool    enabled(loglevel lvl) const
+    {
+        auto l = _level.load(std::memory_order_relaxed);
+        if (l < 0)
+            l = _threshold.load(std::memory_order_relaxed);
+        return static_cast<int>(lvl) >= l;
+    }
+
+    /**
+     * \brief 设定本分类的等级
+     */
+    void    set_level(loglevel lvl) { _level.store(static_cast<int>(lvl), std::memory_order_relaxed); }
+
+    /**
+     * \brief 恢复使用全局等级
+     */
+    void    reset_level() { _level.store(-1, std::memory_order_relaxed); }
+
+    /**
+     * \brief 设定全局等级
+     */
+    static void set_default_level(loglevel lvl) { _threshold.store(static_cast<int>(lvl), std::memory_order_relaxed); }
+
+    static loglevel default_level() { return static_cast<loglevel>(_threshold.load(std::memory_order_relaxed)); }
+
+    /**
+     * \brief 按名称查找分类
+     * \return 未找到返回空
+     */
+    static log_category *find(const char *name)
+    {
+        for (auto c = _head.load(std::memory_order_acquire); c; c = c->_next) {
+            if (std::strcmp(c->_name, name) == 0)
+                return c;
+        }
+        return nullptr;
+    }
+
+    /**
+     * \brief 默认分类，总是使用全局等级
+     */
+    static log_category &root() { return _root; }
+
+private:
+    const char          *_name;
+    std::atomic<int>    _level{ -1 };
+    log_category        *_next{ nullptr };
+
+    static std::atomic<int>             _threshold;
+    static std::atomic<log_category *>  _head;
+    static log_category                 _root;
+};
+
+/**
+ * \brief 日志宏使用的分类，可在源文件中重定义
+ */
+#ifndef BU_LOG_CATEGORY
+#define BU_LOG_CATEGORY     log_category::root()
+#endif
+
 /**
 * \brief logger类，初始化需要
 * \使用方法 LOG_{DEBUG|INFO|WARNING|ERROR|NOTICE|FATAL|FORMAT}(message)
@@ -85,17 +181,46 @@ public:
     static  void    init_logger(const std::string &log_dir,const std::string &file_prefix, uint32_t level);
 
     /**
-     * \brief 格式化函数 采用C++11变长模板
+     * \brief 停止 binlog 后台线程并刷新所有输出，init_logger 会将其登记到 atexit，也可提前调用
+     */
+    static  void    shutdown();
+
+    /**
+     * \brief 运行期修改全局日志等级，不重建输出，可在信号处理函数中调用
+     * \param level 日志过滤等级
+     */
+    static  void    set_level(loglevel level)
+    {
+        log_category::set_default_level(level);
+    }
+
+    /**
+     * \brief 运行期修改分类的日志等级
+     * \param category 分类名称
+     * \param level 日志过滤等级
+     * \return 分类不存在返回 false
+     */
+    static  bool    set_level(const char *category, loglevel level)
+    {
+        auto c = log_category::find(category);
+        if (c)
+            c->set_level(level);
+        return c != nullptr;
+    }
+
+    /**
+     * \brief 格式化函数 采用C++11变长模板，格式与 printf 及 boost::format 的 %N% 兼容
      * \tparam Params 模板参数类型
      * \param fmt 格式化字符串
      * \param params 格式化参数列表
      * \return 格式化好的字符串
      */
     template<typename ...Params>
-    static  std::string  format(const std::string &fmt , Params... params)
+    static  std::string  format(const std::string &fmt , const Params&... params)
     {
-        auto formatter = boost::format(fmt);
-        return std::move(_log_format(formatter, params...).str());
+        std::string out;
+        log_format::format_to(out, fmt.c_str(), params...);
+        return out;
     }
 
     /**
@@ -105,7 +230,7 @@ public:
      */
     static  std::string format(const std::string &fmt)
     {
-        return std::move(fmt);
+        return fmt;
     }
 
 
@@ -113,44 +238,19 @@ public:
      * \brief logger实例类型
      */
     static      boost::log::sources::severity_logger_mt<loglevel>     _logger;
-
-protected:
-
-    /**
-     * \brief 最终格式化递归
-     * \tparam Type 格式化类型
-     * \param fmt 格式化实例
-     * \param value 格式化值
-     * \return 格式化实例
-     */
-    template<typename Type>
-    static  boost::format &  _log_format(boost::format &fmt, const Type& value)
-    {
-        return fmt % value;
-    }
-
-    /**
-     * \brief 格式化递归
-     * \tparam Type 格式化类型
-     * \tparam Params 格式化参数列表
-     * \param fmt 格式化实例
-     * \param value 格式化unpack值
-     * \param params 格式化下个参数列表
-     * \return 格式化实例
-     */
-    template<typename Type, typename ...Params>
-    static  boost::format &  _log_format(boost::format &fmt, const Type& value, Params... params)
-    {
-        return _log_format((fmt % value), params...);
-    }
 };
 
 /**
-* \brief Log宏
+* \brief 日志等级是否输出，先比较编译期最低等级，再读取分类的原子等级
+* \param lvl
+*/
+#define         LOG_ENABLED(lvl)        (static_cast<int>(loglevel::lvl) >= BU_LOG_MIN_LEVEL && (BU_LOG_CATEGORY).enabled(loglevel::lvl))
+/**
+* \brief Log宏，未输出的等级不进入作用域，也不对消息求值
 * \param lvl
 * \param Message
 */
-#define         LOG_LEVEL(lvl,Message)  {BOOST_LOG_FUNC();BOOST_LOG_SEV(logger::_logger,loglevel::lvl)<<Message;}
+#define         LOG_LEVEL(lvl,Message)  {if (LOG_ENABLED(lvl)) {BOOST_LOG_FUNC();BOOST_LOG_SEV(logger::_logger,loglevel::lvl)<<Message;}}
 /**
 * \brief 日志信息等级宏
 * \param Message
@@ -184,10 +284,19 @@ protected:
 
 
 /**
- * \brief 格式化日志
+ * \brief 格式化日志，格式串需为字面量，编译期检查与参数是否匹配；
+ *        定义 BU_LOG_DEFERRED 时只记录参数，由 binlog 的后台线程格式化
  * \param fmt 待格式化字符串
  */
-#define         LOG_FORMAT(fmt,lvl, ...)    LOG_LEVEL(lvl, logger::format(fmt,__VA_ARGS__) )
+#ifdef BU_LOG_DEFERRED
+#define         LOG_FORMAT(fmt,lvl, ...)    {LOG_FORMAT_CHECK(fmt, __VA_ARGS__) \
+                                            if (LOG_ENABLED(lvl)) { \
+                                            static const binlog_site _bu_log_site = { "" fmt, loglevel::lvl, BU_LOG_SITE_FUNCTION, __FILE__, __LINE__ }; \
+                                            binlog::write(_bu_log_site, __VA_ARGS__);}}
+#else
+#define         LOG_FORMAT(fmt,lvl, ...)    {LOG_FORMAT_CHECK(fmt, __VA_ARGS__) \
+                                            LOG_LEVEL(lvl, log_format::format("" fmt, __VA_ARGS__));}
+#endif
  /**
  * \brief 格式化日志信息等级宏
  * \param Message
@@ -217,4 +326,8 @@ protected:
  * \brief 格式化日志崩溃等级宏
  * \param Message
  */
-#define         LOG_FATAL_F(fmt,...)      LOG_FORMAT(fmt,Log_Fatal,__VA_ARGS__)
\ No newline at end of file
+#define         LOG_FATAL_F(fmt,...)      LOG_FORMAT(fmt,Log_Fatal,__VA_ARGS__)
+
+#ifdef BU_LOG_DEFERRED
+#include "binlog.hxx"
+#endif
@@ -10,27 +10,15 @@
 #include "logger/logger.hxx"
 #include <iostream>
 #include "ustring.hxx"
-#include <boost/timer.hpp>
 #include <boost/log/attributes/current_thread_id.hpp>
-#include <boost/thread/v2/thread.hpp>
+#include <boost/thread/thread.hpp>
 
 int main(int argc , char** args)
 {
     
     logger::init_logger("./log", "boost-utils", static_cast<uint32_t>(loglevel::Log_Info));
-    uchar buf[256] = { 1 };
-    uchar dest[256] = { 0 };
-    ustring ubuf(256,1);
+    /*ustring 各操作的耗时见 bench/ustring_bench.cpp*/
 
-    boost::timer timer;
-    {
-        memcpy(dest, buf, 256);   
-        LOG_DEBUG_F("memcpy() time : %f", timer.elapsed());
-    }
-    timer.restart();
-    
-    ustring data(ubuf);
-    LOG_DEBUG_F("copy() time : %f", timer.elapsed());
     
     boost::this_thread::sleep(boost::posix_time::seconds(10000));
 
@@ -0,0 +1,291 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月20日  13:25:09
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: mapped_file.hxx
+//  描述: 内存映射文件，以只读视图方式读取大文件，支持分段映射
+// **************************************************************************/
+#pragma once
+
+#include "ustring_view.hxx"
+#include <boost/noncopyable.hpp>
+#include <boost/system/error_code.hpp>
+#include <algorithm>
+#include <string>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+/**
+ * \brief 映射参数，各项提示在不支持的平台上忽略
+ */
+struct mapped_file_options {
+    /**
+     * \brief 顺序读取提示（MADV_SEQUENTIAL），内核加大预读并及时回收读过的页
+     */
+    bool    sequential{ true };
+    /**
+     * \brief 提前读入提示（MADV_WILLNEED）
+     */
+    bool    willneed{ false };
+    /**
+     * \brief 映射时一次性读入全部页（MAP_POPULATE），避免之后的缺页中断
+     */
+    bool    populate{ false };
+    /**
+     * \brief 尝试使用透明大页（MADV_HUGEPAGE）
+     */
+    bool    huge_pages{ false };
+};
+
+/**
+ * \brief 只读内存映射文件
+ *
+ * 整个文件或其中一段映射为 ustring_view，可直接交给 frame_decoder、byte_searcher 等使用，
+ * 不占用额外的堆内存。地址空间有限或文件很大时使用 for_each_chunk() 逐段映射。
+ */
+class mapped_file final : boost::noncopyable {
+public:
+    mapped_file() {}
+
+    ~mapped_file() {
+        close();
+        close_file();
+    }
+
+    /**
+     * \brief 映射文件
+     * \param path 文件路径
+     * \param ec 错误代码
+     * \param opts 映射参数
+     * \param offset 起始偏移，会向下对齐到映射粒度，view() 仍从 offset 开始
+     * \param length 映射长度，0 表示到文件末尾
+     * \return 是否成功
+     */
+    bool open(const std::string &path, ERRCODE &ec, const mapped_file_options &opts = mapped_file_options(),
+        qword offset = 0, size_t length = 0) {
+        close();
+        qword file_size = 0;
+        if (!open_file(path, file_size, ec))
+            return false;
+        auto ok = map_from(*this, file_size, offset, length, opts, ec);
+        close_file();
+        return ok;
+    }
+
+    /**
+     * \brief 解除映射
+     */
+    void close() {
+        if (!region)
+            return;
+#ifdef WIN32
+        UnmapViewOfFile(region);
+#else
+        munmap(region, region_len);
+#endif
+        region = nullptr;
+        region_len = 0;
+        first = nullptr;
+        count = 0;
+    }
+
+    bool is_open() const { return region != nullptr; }
+
+    /**
+     * \brief 映射内容的视图
+     */
+    ustring_view view() const { return ustring_view(first, count); }
+
+    operator ustring_view() const { return view(); }
+
+    const uchar *data() const { return first; }
+    size_t size() const { return count; }
+
+    /**
+     * \brief 逐段映射整个文件，每次只保留一段映射
+     * \tparam _Func 回调类型，签名为 bool(ustring_view chunk, qword offset)，返回false停止
+     * \param path 文件路径
+     * \param chunk_size 每段大小，为0时返回 invalid_argument
+     * \param f 回调
+     * \param ec 错误代码
+     * \param opts 映射参数
+     * \return 是否读完整个文件
+     */
+    template<class _Func>
+    static bool for_each_chunk(const std::string &path, size_t chunk_size, _Func &&f, ERRCODE &ec,
+        const mapped_file_options &opts = mapped_file_options()) {
+        if (chunk_size == 0) {
+            ec = boost::system::errc::make_error_code(boost::system::errc::invalid_argument);
+            return false;
+        }
+        mapped_file probe;
+        qword file_size = 0;
+        if (!probe.open_file(path, file_size, ec))
+            return false;
+        for (qword off = 0; off < file_size; off += chunk_size) {
+            auto len = static_cast<size_t>(std::min<qword>(chunk_size, file_size - off));
+            mapped_file chunk;
+            if (!chunk.map_from(probe, file_size, off, len, opts, ec))
+                return false;
+            if (!f(chunk.view(), off))
+                return false;
+        }
+        return true;
+    }
+
+private:
+
+    static size_t granularity() {
+#ifdef WIN32
+        SYSTEM_INFO si;
+        GetSystemInfo(&si);
+        return si.dwAllocationGranularity;
+#else
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+
+    static ERRCODE last_error() {
+#ifdef WIN32
+        return ERRCODE(static_cast<int>(GetLastError()), boost::system::system_category());
+#else
+        return ERRCODE(errno, boost::system::system_category());
+#endif
+    }
+
+    bool open_file(const std::string &path, qword &file_size, ERRCODE &ec) {
+#ifdef WIN32
+        fh = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (fh == INVALID_HANDLE_VALUE) {
+            ec = last_error();
+            return false;
+        }
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(fh, &sz)) {
+            ec = last_error();
+            close_file();
+            return false;
+        }
+        file_size = static_cast<qword>(sz.QuadPart);
+        if (file_size > 0) {
+            mh = CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mh) {
+                ec = last_error();
+                close_file();
+                return false;
+            }
+        }
+#else
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            ec = last_error();
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ec = last_error();
+            close_file();
+            return false;
+        }
+        file_size = static_cast<qword>(st.st_size);
+#endif
+        ec.clear();
+        return true;
+    }
+
+    void close_file() {
+#ifdef WIN32
+        if (mh)
+            CloseHandle(mh);
+        if (fh != INVALID_HANDLE_VALUE)
+            CloseHandle(fh);
+        mh = nullptr;
+        fh = INVALID_HANDLE_VALUE;
+#else
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+#endif
+    }
+
+    /**
+     * \brief 使用 src 已打开的文件映射一段
+     */
+    bool map_from(const mapped_file &src, qword file_size, qword offset, size_t length,
+        const mapped_file_options &opts, ERRCODE &ec) {
+        ec.clear();
+        if (offset > file_size) {
+            ec = boost::system::errc::make_error_code(boost::system::errc::invalid_argument);
+            return false;
+        }
+        if (length == 0 || length > file_size - offset)
+            length = static_cast<size_t>(file_size - offset);
+        if (length == 0)
+            return true;
+
+        auto aligned = offset / granularity() * granularity();
+        auto skip = static_cast<size_t>(offset - aligned);
+        auto len = length + skip;
+#ifdef WIN32
+        auto p = MapViewOfFile(src.mh, FILE_MAP_READ, static_cast<DWORD>(aligned >> 32),
+            static_cast<DWORD>(aligned & 0xFFFFFFFF), len);
+        if (!p) {
+            ec = last_error();
+            return false;
+        }
+        (void)opts;
+#else
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        if (opts.populate)
+            flags |= MAP_POPULATE;
+#endif
+        auto p = mmap(nullptr, len, PROT_READ, flags, src.fd, static_cast<off_t>(aligned));
+        if (p == MAP_FAILED) {
+            ec = last_error();
+            return false;
+        }
+        /*提示失败不影响使用*/
+        if (opts.sequential)
+            madvise(p, len, MADV_SEQUENTIAL);
+        if (opts.willneed)
+            madvise(p, len, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+        if (opts.huge_pages)
+            madvise(p, len, MADV_HUGEPAGE);
+#endif
+#endif
+        region = p;
+        region_len = len;
+        first = static_cast<const uchar *>(p) + skip;
+        count = length;
+        return true;
+    }
+
+#ifdef WIN32
+    HANDLE          fh{ INVALID_HANDLE_VALUE };
+    HANDLE          mh{ nullptr };
+#else
+    int             fd{ -1 };
+#endif
+    /**
+     * \brief 映射区域（已对齐）
+     */
+    void            *region{ nullptr };
+    size_t          region_len{ 0 };
+    /**
+     * \brief 视图范围
+     */
+    const uchar     *first{ nullptr };
+    size_t          count{ 0 };
+};
@@ -0,0 +1,271 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月20日  17:03:29
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: parallel_ops.hxx
+//  描述: 大字节串在线程池上分块并行的十六进制转换、校验和与查找
+// **************************************************************************/
+#pragma once
+
+#include "byte_search.hxx"
+#include "checksum.hxx"
+#include "threadpool/pool.hpp"
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * \brief 分块参数
+ */
+struct parallel_options {
+    /**
+     * \brief 小于该长度时直接在调用线程串行处理
+     */
+    size_t  min_parallel{ 1024 * 1024 };
+    /**
+     * \brief 每块大小
+     */
+    size_t  chunk_size{ 256 * 1024 };
+};
+
+/**
+ * \brief 分块并行运算
+ *
+ * 把数据切成若干块，调用线程与线程池中的若干任务一起按序号领取块处理，各块结果写入
+ * 预先分配好的位置，最后在调用线程合并。调用线程自身也处理块，线程池繁忙时退化为串行，
+ * 不会因等待排队的任务而卡住。
+ * \tparam _Pool 线程池类型，默认为 fifo 线程池
+ */
+template<class _Pool = boost::threadpool::fifo_pool>
+class parallel_ops final {
+public:
+    /**
+     * \brief 构造
+     * \param pool 线程池，生存期需长于本对象
+     * \param opts 分块参数
+     */
+    explicit parallel_ops(_Pool &pool, const parallel_options &opts = parallel_options())
+        : pool(pool), options(opts) {
+        if (options.chunk_size == 0)
+            options.chunk_size = 1;
+    }
+
+    /**
+     * \brief 转换为十六进制字符串，格式与 ustring::to_hexstring 相同
+     * \param data 数据
+     * \param split_str 分割符
+     * \param is_upper 大小写
+     * \return 十六进制字符串
+     */
+    std::string to_hexstring(ustring_view data, const char *split_str = nullptr, bool is_upper = true) {
+        auto split_len = split_str ? strlen(split_str) : 0;
+        auto width = 2 + split_len;
+        std::string out(data.size() * width, '\0');
+        auto dst = &out[0];
+        /*每个字节的输出宽度固定，各块直接写到自己的位置*/
+        for_each_chunk(data.size(), [&](size_t, size_t begin, size_t end) {
+            write_hex(data.data() + begin, end - begin, dst + begin * width, split_str, split_len, is_upper);
+        });
+        return out;
+    }
+
+    /**
+     * \brief 计算 CRC32C，各块独立计算后用 crc32c::combine 合并
+     * \param data 数据
+     * \return 校验值
+     */
+    uint crc32c_of(ustring_view data) {
+        auto count = chunk_count(data.size());
+        if (count == 0)
+            return crc32c::compute(data);
+        std::vector<uint> parts(count);
+        for_each_chunk(data.size(), [&](size_t idx, size_t begin, size_t end) {
+            parts[idx] = crc32c::compute(data.substr(begin, end - begin));
+        });
+        auto crc = parts[0];
+        for (size_t i = 1; i < parts.size(); ++i) {
+            auto begin = i * options.chunk_size;
+            auto len = std::min(options.chunk_size, data.size() - begin);
+            crc = crc32c::combine(crc, parts[i], len);
+        }
+        return crc;
+    }
+
+    /**
+     * \brief 查找第一次出现的位置
+     *
+     * 每块查找起点落在本块内的匹配，读取范围向后多延伸 pattern.size() - 1 字节，
+     * 跨块边界的匹配归属起点所在的块，不会遗漏也不会重复。
+     * \param data 数据
+     * \param pattern 模式
+     * \return 位置，未找到返回 byte_searcher::npos
+     */
+    size_t find(ustring_view data, ustring_view pattern) {
+        const size_t not_found = byte_searcher::npos;
+        byte_searcher searcher(pattern);
+        if (chunk_count(data.size()) == 0)
+            return searcher.find(data);
+        std::atomic<size_t> best(not_found);
+        for_each_chunk(data.size(), [&](size_t, size_t begin, size_t end) {
+            /*前面的块已经找到时跳过*/
+            if (best.load(std::memory_order_relaxed) < begin)
+                return;
+            auto pos = find_in(searcher, data, pattern.size(), begin, end);
+            if (pos == not_found)
+                return;
+            auto cur = best.load(std::memory_order_relaxed);
+            while (pos < cur && !best.compare_exchange_weak(cur, pos, std::memory_order_relaxed)) {}
+        });
+        return best.load();
+    }
+
+    /**
+     * \brief 查找所有出现的位置（允许重叠），按位置升序
+     * \param data 数据
+     * \param pattern 模式，不能为空
+     * \return 位置列表
+     */
+    std::vector<size_t> find_all(ustring_view data, ustring_view pattern) {
+        const size_t not_found = byte_searcher::npos;
+        byte_searcher searcher(pattern);
+        std::vector<size_t> result;
+        if (pattern.empty())
+            return result;
+        std::vector<std::vector<size_t>> parts(std::max<size_t>(chunk_count(data.size()), 1));
+        auto collect = [&](size_t idx, size_t begin, size_t end) {
+            auto &hits = parts[idx];
+            for (auto pos = begin; pos < end; ++pos) {
+                pos = find_in(searcher, data, pattern.size(), pos, end);
+                if (pos == not_found)
+                    break;
+                hits.push_back(pos);
+            }
+        };
+        for_each_chunk(data.size(), collect);
+        for (auto &hits : parts)
+            result.insert(result.end(), hits.begin(), hits.end());
+        return result;
+    }
+
+    /**
+     * \brief 分块参数
+     */
+    const parallel_options &get_options() const { return options; }
+
+private:
+
+    /**
+     * \brief 块数，低于并行阈值时返回0
+     */
+    size_t chunk_count(size_t n) const {
+        if (n < options.min_parallel || n <= options.chunk_size)
+            return 0;
+        return (n + options.chunk_size - 1) / options.chunk_size;
+    }
+
+    /**
+     * \brief 在 [begin, end) 中查找起点，读取到 end + m - 1 为止
+     */
+    static size_t find_in(const byte_searcher &searcher, ustring_view data, size_t m, size_t begin, size_t end) {
+        auto limit = std::min(data.size(), end + (m ? m - 1 : 0));
+        auto pos = searcher.find(data.substr(begin, limit - begin));
+        if (pos == byte_searcher::npos || begin + pos >= end)
+            return byte_searcher::npos;
+        return begin + pos;
+    }
+
+    static void write_hex(const uchar *p, size_t n, char *out, const char *split_str, size_t split_len, bool is_upper) {
+        static const char upper_digits[] = "0123456789ABCDEF";
+        static const char lower_digits[] = "0123456789abcdef";
+        auto digits = is_upper ? upper_digits : lower_digits;
+        for (size_t i = 0; i < n; ++i) {
+            *out++ = digits[p[i] >> 4];
+            *out++ = digits[p[i] & 0x0F];
+            if (split_len) {
+                memcpy(out, split_str, split_len);
+                out += split_len;
+            }
+        }
+    }
+
+    using _Mutex = boost::mutex;
+
+    /**
+     * \brief 各块共享的领取与完成计数
+     */
+    struct _Batch {
+        std::atomic<size_t>         next{ 0 };
+        /**
+         * \brief 已有块抛出异常，之后领取的块不再执行
+         */
+        std::atomic<bool>           failed{ false };
+        size_t                      total{ 0 };
+        size_t                      done{ 0 };
+        std::exception_ptr          error;
+        _Mutex                      mutex;
+        boost::condition_variable   cond;
+    };
+
+    /**
+     * \brief 按块执行，f(块序号, 起点, 终点)，低于阈值时整段作为一块在调用线程执行
+     *
+     * f 抛出的异常在各线程内捕获，等所有块结束（余下的块跳过）后在调用线程重新抛出第一个。
+     */
+    template<class _Func>
+    void for_each_chunk(size_t n, _Func &&f) {
+        auto count = chunk_count(n);
+        if (count == 0) {
+            f(0, 0, n);
+            return;
+        }
+        auto chunk = options.chunk_size;
+        auto batch = std::make_shared<_Batch>();
+        batch->total = count;
+        /*任务持有 batch 的共享指针，调用返回后才开始运行的任务领取不到块，直接退出*/
+        auto work = [batch, chunk, n, &f]() {
+            size_t finished = 0;
+            for (;;) {
+                auto idx = batch->next.fetch_add(1);
+                if (idx >= batch->total)
+                    break;
+                ++finished;
+                if (batch->failed.load(std::memory_order_relaxed))
+                    continue;
+                auto begin = idx * chunk;
+                try {
+                    f(idx, begin, std::min(n, begin + chunk));
+                }
+                catch (...) {
+                    _Mutex::scoped_lock lock(batch->mutex);
+                    if (!batch->error)
+                        batch->error = std::current_exception();
+                    batch->failed.store(true, std::memory_order_relaxed);
+                }
+            }
+            if (finished) {
+                _Mutex::scoped_lock lock(batch->mutex);
+                batch->done += finished;
+                if (batch->done == batch->total)
+                    batch->cond.notify_all();
+            }
+        };
+        auto helpers = std::min(count - 1, pool.size());
+        for (size_t i = 0; i < helpers; ++i)
+            pool.schedule(work);
+        work();
+        _Mutex::scoped_lock lock(batch->mutex);
+        while (batch->done < batch->total)
+            batch->cond.wait(lock);
+        if (batch->error)
+            std::rethrow_exception(batch->error);
+    }
+
+    _Pool               &pool;
+    parallel_options    options;
+};
@@ -0,0 +1,170 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月19日  14:10:33
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: random_bytes.hxx
+//  描述: 随机字节生成：快速非加密 wyrand 与系统加密随机源
+// **************************************************************************/
+#pragma once
+
+#include "types.hxx"
+#include <boost/system/system_error.hpp>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#ifdef WIN32
+#include <windows.h>
+#include <bcrypt.h>
+#include <winternl.h>
+#pragma comment(lib, "bcrypt.lib")
+#pragma comment(lib, "ntdll.lib")
+#else
+#include <sys/random.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * \brief 系统加密安全随机源，Linux 使用 getrandom()，Windows 使用 BCryptGenRandom
+ */
+class secure_random final {
+public:
+    /**
+     * \brief 填充随机字节，失败时抛出 boost::system::system_error
+     * \param ptr 目标地址
+     * \param len 长度
+     */
+    static void fill(uchar *ptr, size_t len) {
+#ifdef WIN32
+        while (len > 0) {
+            auto n = static_cast<ULONG>(len > 0x10000000 ? 0x10000000 : len);
+            /*返回 NTSTATUS，不设置 GetLastError()，转换为 Win32 错误码后报告*/
+            auto status = BCryptGenRandom(nullptr, ptr, n, BCRYPT_USE_SYSTEM_PREFERRED_RNG);
+            if (!BCRYPT_SUCCESS(status))
+                throw boost::system::system_error(
+                    ERRCODE(static_cast<int>(RtlNtStatusToDosError(status)), boost::system::system_category()),
+                    "BCryptGenRandom");
+            ptr += n;
+            len -= n;
+        }
+#else
+        while (len > 0) {
+            auto n = getrandom(ptr, len, 0);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw boost::system::system_error(
+                    ERRCODE(errno, boost::system::system_category()), "getrandom");
+            }
+            ptr += n;
+            len -= static_cast<size_t>(n);
+        }
+#endif
+    }
+
+    /**
+     * \brief 取一个随机64位数
+     * \return 随机数
+     */
+    static qword next() {
+        qword v;
+        fill(reinterpret_cast<uchar *>(&v), sizeof(v));
+        return v;
+    }
+};
+
+/**
+ * \brief 快速非加密随机数 wyrand，每个线程独立状态，不能用于密钥或令牌
+ */
+class fast_random final {
+public:
+    /**
+     * \brief 取一个随机64位数
+     * \return 随机数
+     */
+    static qword next() {
+        return step(state());
+    }
+
+    /**
+     * \brief 按64位一次填充随机字节
+     * \param ptr 目标地址
+     * \param len 长度
+     */
+    static void fill(uchar *ptr, size_t len) {
+        auto &s = state();
+        qword v;
+        while (len >= sizeof(v)) {
+            v = step(s);
+            std::memcpy(ptr, &v, sizeof(v));
+            ptr += sizeof(v);
+            len -= sizeof(v);
+        }
+        if (len > 0) {
+            v = step(s);
+            std::memcpy(ptr, &v, len);
+        }
+    }
+
+    /**
+     * \brief 重新设定当前线程的种子，用于复现压测数据
+     * \param seed 种子
+     */
+    static void seed(qword seed) {
+        state() = seed;
+    }
+
+private:
+
+    /**
+     * \brief 线程状态，首次使用时由系统随机源播种
+     */
+    static qword &state() {
+        static thread_local qword s = initial_seed();
+        return s;
+    }
+
+    static qword initial_seed() {
+        try {
+            return secure_random::next();
+        }
+        catch (const boost::system::system_error &) {
+            qword local = 0;
+            return static_cast<qword>(std::hash<std::thread::id>()(std::this_thread::get_id()))
+                ^ static_cast<qword>(reinterpret_cast<uintptr_t>(&local));
+        }
+    }
+
+    static qword step(qword &s) {
+        s += 0xa0761d6478bd642fULL;
+        return mum(s, s ^ 0xe7037ed1a0b428dbULL);
+    }
+
+    /**
+     * \brief 64x64 乘法，返回128位结果高低两半的异或
+     */
+    static qword mum(qword a, qword b) {
+#if defined(__SIZEOF_INT128__)
+        auto r = static_cast<unsigned __int128>(a) * b;
+        return static_cast<qword>(r) ^ static_cast<qword>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        qword hi;
+        qword lo = _umul128(a, b, &hi);
+        return lo ^ hi;
+#else
+        qword ha = a >> 32, hb = b >> 32, la = static_cast<dword>(a), lb = static_cast<dword>(b);
+        qword rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+        qword t = rl + (rm0 << 32);
+        qword c = t < rl;
+        qword lo = t + (rm1 << 32);
+        c += lo < t;
+        qword hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+        return lo ^ hi;
+#endif
+    }
+};
@@ -0,0 +1,232 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月20日  10:36:52
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: ring_buffer.hxx
+//  描述: 连接接收用的连续环形字节缓冲，支持双重映射与高低水位
+// **************************************************************************/
+#pragma once
+
+#include "ustring_view.hxx"
+#include <boost/asio/buffer.hpp>
+#include <boost/noncopyable.hpp>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * \brief 环形字节缓冲
+ *
+ * 替代“尾部追加、头部 erase”的 ustring 接收缓冲：prepare() 给出可直接交给
+ * async_read_some 的可写区域，data() 给出交给解析器的可读区域，consume() 只移动读位置。
+ *
+ * Linux 下默认使用 memfd 把同一块物理内存映射到相邻的两段虚拟地址，
+ * 绕回时可读、可写区域也始终连续，从不搬移数据；
+ * 映射失败或其他平台退化为普通缓冲，只在尾部空间不够时才把剩余数据搬到头部。
+ */
+class byte_ring final : boost::noncopyable {
+public:
+    /**
+     * \brief 构造
+     * \param capacity 容量，双重映射时向上取整到页大小
+     * \param mirrored 是否尝试双重映射
+     */
+    explicit byte_ring(size_t capacity, bool mirrored = true) {
+        if (!mirrored || !map_mirror(capacity)) {
+            flat.reset(new uchar[capacity]);
+            base = flat.get();
+            cap = capacity;
+        }
+        high_mark = cap;
+        low_mark = cap / 2;
+    }
+
+    ~byte_ring() {
+#ifdef __linux__
+        if (!flat && base)
+            munmap(base, cap * 2);
+#endif
+    }
+
+    /**
+     * \brief 是否为双重映射模式
+     */
+    bool mirrored() const { return !flat; }
+
+    /**
+     * \brief 容量
+     */
+    size_t capacity() const { return cap; }
+
+    /**
+     * \brief 可读字节数
+     */
+    size_t size() const { return static_cast<size_t>(wpos - rpos); }
+
+    bool empty() const { return wpos == rpos; }
+
+    /**
+     * \brief 剩余可写字节数
+     */
+    size_t free_space() const { return cap - size(); }
+
+    /**
+     * \brief 可读区域，consume() 之前有效
+     * \return 视图
+     */
+    ustring_view data() const {
+        return ustring_view(base + offset(rpos), size());
+    }
+
+    /**
+     * \brief 取得可写区域
+     * \param min_bytes 至少需要的连续字节数，普通缓冲模式下尾部不够时才搬移数据
+     * \return 可写区域，可能比 min_bytes 大，剩余空间不足时比 min_bytes 小
+     */
+    boost::asio::mutable_buffer prepare(size_t min_bytes = 1) {
+        if (flat) {
+            auto tail_room = cap - static_cast<size_t>(wpos);
+            if (tail_room < min_bytes && rpos > 0) {
+                auto n = size();
+                std::memmove(base, base + rpos, n);
+                rpos = 0;
+                wpos = n;
+                ++compactions;
+            }
+            return boost::asio::mutable_buffer(base + wpos, cap - static_cast<size_t>(wpos));
+        }
+        return boost::asio::mutable_buffer(base + offset(wpos), free_space());
+    }
+
+    /**
+     * \brief 提交写入的字节
+     * \param n 字节数，不能超过 prepare() 给出的大小
+     */
+    void commit(size_t n) {
+        wpos += n;
+        if (size() >= high_mark)
+            paused = true;
+    }
+
+    /**
+     * \brief 丢弃已处理的字节
+     * \param n 字节数，超出时全部丢弃
+     */
+    void consume(size_t n) {
+        if (n > size())
+            n = size();
+        rpos += n;
+        if (flat && rpos == wpos)
+            rpos = wpos = 0;
+        else if (!flat && rpos >= cap) {
+            rpos -= cap;
+            wpos -= cap;
+        }
+        if (size() <= low_mark)
+            paused = false;
+    }
+
+    /**
+     * \brief 复制写入
+     * \param v 数据
+     * \return 实际写入的字节数
+     */
+    size_t write(ustring_view v) {
+        auto buf = prepare(v.size());
+        auto n = std::min(v.size(), boost::asio::buffer_size(buf));
+        std::memcpy(boost::asio::buffer_cast<uchar *>(buf), v.data(), n);
+        commit(n);
+        return n;
+    }
+
+    /**
+     * \brief 设定水位，可读字节数达到高水位时暂停读取，降到低水位时恢复
+     * \param low 低水位
+     * \param high 高水位
+     */
+    void set_watermarks(size_t low, size_t high) {
+        low_mark = low;
+        high_mark = high;
+        paused = size() >= high_mark;
+    }
+
+    /**
+     * \brief 是否应该暂停从套接字读取
+     */
+    bool read_paused() const { return paused; }
+
+    /**
+     * \brief 普通缓冲模式下搬移数据的次数
+     */
+    size_t compaction_count() const { return compactions; }
+
+private:
+
+    size_t offset(qword pos) const {
+        return flat ? static_cast<size_t>(pos) : static_cast<size_t>(pos % cap);
+    }
+
+    /**
+     * \brief 把同一块 memfd 映射到相邻的两段地址
+     */
+    bool map_mirror(size_t capacity) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+        auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        auto len = (capacity + page - 1) / page * page;
+        int fd = static_cast<int>(syscall(SYS_memfd_create, "byte_ring", 1u /*MFD_CLOEXEC*/));
+        if (fd < 0)
+            return false;
+        if (ftruncate(fd, static_cast<off_t>(len)) != 0) {
+            close(fd);
+            return false;
+        }
+        auto area = static_cast<uchar *>(mmap(nullptr, len * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (area == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        auto a = mmap(area, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        auto b = mmap(area + len, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        close(fd);
+        if (a == MAP_FAILED || b == MAP_FAILED) {
+            munmap(area, len * 2);
+            return false;
+        }
+        base = area;
+        cap = len;
+        return true;
+#else
+        (void)capacity;
+        return false;
+#endif
+    }
+
+    /**
+     * \brief 普通缓冲模式下的内存
+     */
+    std::unique_ptr<uchar[]>    flat;
+    /**
+     * \brief 缓冲起始地址
+     */
+    uchar                       *base{ nullptr };
+    size_t                      cap{ 0 };
+    /**
+     * \brief 读写位置，双重映射模式下取模得到偏移
+     */
+    qword                       rpos{ 0 };
+    qword                       wpos{ 0 };
+    /**
+     * \brief 高低水位
+     */
+    size_t                      high_mark;
+    size_t                      low_mark;
+    bool                        paused{ false };
+    size_t                      compactions{ 0 };
+};
@@ -0,0 +1,499 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月21日  14:26:05
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: sharded_timer.hxx
+//  描述: 按线程分片的定时器，每个 io_service 一个时间轮
+// **************************************************************************/
+#pragma once
+
+#include <boost/align/aligned_allocator.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/function.hpp>
+#include <boost/bind.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <boost/smart_ptr/intrusive_ref_counter.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "forever_timer.hxx"
+#include "timing_wheel.hxx"
+#include "types.hxx"
+
+/**
+ * \brief 分片循环定时器
+ *
+ * 每个 io_service 一个分片，分片有自己的时间轮与 asio 定时器，只由运行该 io_service 的线程访问，
+ * 因此每个 io_service 只能由一个线程运行。在分片线程上加入、取消与推迟任务直接操作时间轮，不加锁；
+ * 在其他线程上的操作作为消息压入目标分片的无锁队列，由分片线程批量取出处理。
+ * 在非分片线程上加入的任务轮流分配到各分片。分片线程由构造时投递到各 io_service 的 handler
+ * 记在线程局部变量中，add_doing 查找本线程的分片为 O(1)，不逐个询问各分片。
+ *
+ * 回调在所属分片的线程上执行；截止时间与追赶策略同 forever_timer。
+ * 本对象需在各 io_service 停止运行后析构。
+ */
+class sharded_timer final : boost::noncopyable
+{
+public:
+    /**
+     * \brief 回调函数定义
+     */
+    using _DoingType = boost::function<void()>;
+    /**
+     * \brief 定时器定义
+     */
+    using _SteadyTimer = boost::asio::steady_timer;
+    /**
+     * \brief 调度器定义
+     */
+    using _IoService = boost::asio::io_service;
+    /**
+     * \brief 时钟定义
+     */
+    using _Clock = std::chrono::steady_clock;
+    /**
+     * \brief 追赶策略，同 forever_timer
+     */
+    using catch_up = forever_timer::catch_up;
+
+private:
+    struct _Task;
+    struct _Shard;
+
+public:
+    /**
+     * \brief 任务句柄，可复制，可在任意线程使用
+     */
+    class handle {
+    public:
+        handle() {}
+
+        /**
+         * \brief 取消任务，在其他线程调用时取消在分片线程上异步完成，但之后不会再触发
+         * \return 任务原先在运行返回true
+         */
+        bool    cancel()
+        {
+            if (!task || !task->active.exchange(false))
+                return false;
+            task->owner->send(*task->shard, _Op::cancel, task.get(), _Clock::duration(0));
+            return true;
+        }
+
+        /**
+         * \brief 以新的周期从当前时间重新计时
+         * \param period 新周期
+         * \return 任务已取消返回false
+         */
+        template<class _Rep, class _Period>
+        bool    reset(std::chrono::duration<_Rep, _Period> period)
+        {
+            if (!task || !task->active.load())
+                return false;
+            auto p = std::chrono::duration_cast<_Clock::duration>(period);
+            task->owner->send(*task->shard, _Op::reset, task.get(), task->owner->clamp_period(p));
+            return true;
+        }
+
+        /**
+         * \brief 按原周期从当前时间重新计时
+         * \return 任务已取消返回false
+         */
+        bool    reset()
+        {
+            if (!task || !task->active.load())
+                return false;
+            task->owner->send(*task->shard, _Op::reset, task.get(), _Clock::duration(0));
+            return true;
+        }
+
+        /**
+         * \brief 任务是否仍在运行
+         */
+        bool    active() const { return task && task->active.load(); }
+
+        explicit operator bool() const { return task != nullptr; }
+
+    private:
+        friend class sharded_timer;
+        explicit handle(_Task *t) : task(t) {}
+
+        boost::intrusive_ptr<_Task> task;
+    };
+
+    /**
+     * \brief 构造，构造初始不启动计时器
+     * \param services 各分片的调度器，生存期需长于本对象
+     * \param tick 时间轮最低层的刻度，默认1毫秒
+     */
+    explicit sharded_timer(const std::vector<_IoService *> &services,
+        std::chrono::microseconds tick = std::chrono::milliseconds(1))
+        : tick_len(tick.count() > 0 ? _Clock::duration(tick) : _Clock::duration(std::chrono::microseconds(1)))
+        , origin(_Clock::now())
+    {
+        shards.reserve(services.size());
+        for (auto io : services)
+            shards.emplace_back(new _Shard(*io));
+        for (auto &s : shards)
+            s->io.post(boost::bind(&sharded_timer::bind_thread, this, s.get()));
+    }
+
+    ~sharded_timer()
+    {
+        for (auto &s : shards) {
+            ERRCODE ec;
+            s->timer.cancel(ec);
+            /*未处理的 add 消息还持有 add_doing 中为登记取得的引用*/
+            s->inbox.consume_all([](const _Message &m) {
+                if (m.op == _Op::add)
+                    intrusive_ptr_release(m.task);
+                boost::intrusive_ptr<_Task> ref(m.task, false);
+            });
+            while (s->tasks)
+                unregister(*s, *s->tasks);
+        }
+    }
+
+    /**
+     * \brief 分片数
+     */
+    size_t  size() const { return shards.size(); }
+
+    /**
+     * \brief 加入循环任务，在分片线程上调用时加入本分片
+     * \param period 周期，精度为刻度长度
+     * \param d 回调
+     * \param policy 追赶策略
+     * \return 任务句柄
+     */
+    template<class _Rep, class _Period>
+    handle  add_doing(std::chrono::duration<_Rep, _Period> period, const _DoingType &d,
+        catch_up policy = catch_up::skip)
+    {
+        auto p = clamp_period(std::chrono::duration_cast<_Clock::duration>(period));
+        auto &c = current();
+        auto target = c.serial == serial ? c.shard : nullptr;
+        if (!target)
+            target = shards[next_shard.fetch_add(1, std::memory_order_relaxed) % shards.size()].get();
+
+        auto task = new _Task;
+        task->owner = this;
+        task->shard = target;
+        task->period = p;
+        task->policy = policy;
+        task->doing = d;
+        handle h(task);
+        /*登记持有的引用，在 unregister 中释放*/
+        intrusive_ptr_add_ref(task);
+        send(*target, _Op::add, task, p);
+        return h;
+    }
+
+    /**
+     * \brief 加入循环任务
+     * \param sec 周期（秒）
+     * \param d 回调
+     * \return 任务句柄
+     */
+    handle  add_doing(uint sec, const _DoingType &d)
+    {
+        return add_doing(std::chrono::seconds(sec), d);
+    }
+
+private:
+
+    enum class _Op : uchar { add, cancel, reset };
+
+    /**
+     * \brief 跨线程消息，消息持有任务的一个引用
+     */
+    struct _Message {
+        _Task               *task;
+        _Clock::rep         when;
+        _Clock::rep         period;
+        _Op                 op;
+    };
+
+    /**
+     * \brief 任务，嵌入时间轮节点，引用计数由句柄、登记与在途消息共同持有
+     */
+    struct _Task : timer_node, boost::intrusive_ref_counter<_Task, boost::thread_safe_counter> {
+        sharded_timer       *owner{ nullptr };
+        _Shard              *shard{ nullptr };
+        _Clock::duration    period{ 0 };
+        _Clock::time_point  deadline;
+        catch_up            policy{ catch_up::skip };
+        _DoingType          doing;
+        /**
+         * \brief 句柄可见的状态，取消时在调用线程上立即清除
+         */
+        std::atomic<bool>   active{ true };
+        /**
+         * \brief 以下只由分片线程访问
+         */
+        bool                registered{ false };
+        _Task               *reg_prev{ nullptr };
+        _Task               *reg_next{ nullptr };
+    };
+
+    /**
+     * \brief 分片
+     */
+    struct _Shard : boost::noncopyable {
+        explicit _Shard(_IoService &io_service)
+            : io(io_service), timer(io_service), inbox(64) {}
+
+        _IoService          &io;
+        _SteadyTimer        timer;
+        timing_wheel        wheel;
+        /**
+         * \brief 队列节点按缓存行对齐，C++14 的默认分配器不保证
+         */
+        boost::lockfree::queue<_Message,
+            boost::lockfree::allocator<boost::alignment::aligned_allocator<_Message, 64>>> inbox;
+        /**
+         * \brief 已投递处理消息的 handler 尚未开始取消息
+         */
+        std::atomic<bool>   drain_posted{ false };
+        bool                started{ false };
+        qword               armed_tick{ 0 };
+        _Task               *tasks{ nullptr };
+        /**
+         * \brief 推进时到期的任务，复用容量
+         */
+        std::vector<boost::intrusive_ptr<_Task>>    fired;
+    };
+
+    /**
+     * \brief 本线程所属的分片，serial 区分定时器实例，已析构实例的记录不会与新实例匹配
+     */
+    struct _Current {
+        qword               serial{ 0 };
+        _Shard              *shard{ nullptr };
+    };
+
+    static _Current &current()
+    {
+        static thread_local _Current c;
+        return c;
+    }
+
+    static qword next_serial()
+    {
+        static std::atomic<qword> counter{ 0 };
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    /**
+     * \brief 在分片线程上记下本线程所属的分片
+     */
+    void    bind_thread(_Shard *s)
+    {
+        auto &c = current();
+        c.serial = serial;
+        c.shard = s;
+    }
+
+    /**
+     * \brief 当前线程是否为分片线程
+     */
+    static bool owned(_Shard &s)
+    {
+        return s.io.get_executor().running_in_this_thread();
+    }
+
+    /**
+     * \brief 在分片线程上直接执行，否则压入分片的消息队列
+     */
+    void    send(_Shard &s, _Op op, _Task *task, _Clock::duration period)
+    {
+        auto now = _Clock::now();
+        if (owned(s)) {
+            apply(s, op, *task, now, period);
+            arm(s);
+            return;
+        }
+
+        _Message m;
+        m.task = task;
+        m.when = now.time_since_epoch().count();
+        m.period = period.count();
+        m.op = op;
+        intrusive_ptr_add_ref(task);
+        s.inbox.push(m);
+        /*一批消息只投递一次 handler*/
+        if (!s.drain_posted.exchange(true))
+            s.io.post(boost::bind(&sharded_timer::drain, this, &s));
+    }
+
+    /**
+     * \brief 分片线程取出全部消息处理
+     */
+    void    drain(_Shard *s)
+    {
+        s->drain_posted.store(false);
+        s->inbox.consume_all([this, s](const _Message &m) {
+            boost::intrusive_ptr<_Task> ref(m.task, false);
+            apply(*s, m.op, *m.task, _Clock::time_point(_Clock::duration(m.when)), _Clock::duration(m.period));
+        });
+        arm(*s);
+    }
+
+    /**
+     * \brief 在分片线程上执行操作
+     * \param now 发出操作的时间
+     * \param period 新周期，为0时沿用原周期
+     */
+    void    apply(_Shard &s, _Op op, _Task &task, _Clock::time_point now, _Clock::duration period)
+    {
+        switch (op) {
+        case _Op::add:
+            /*加入后、处理前已被取消，释放登记的引用*/
+            if (!task.active.load()) {
+                intrusive_ptr_release(&task);
+                return;
+            }
+            task.registered = true;
+            task.reg_next = s.tasks;
+            if (s.tasks)
+                s.tasks->reg_prev = &task;
+            s.tasks = &task;
+            task.deadline = now + task.period;
+            s.wheel.schedule(task, deadline_tick(task.deadline));
+            break;
+        case _Op::cancel:
+            if (task.registered)
+                unregister(s, task);
+            break;
+        case _Op::reset:
+            if (!task.registered || !task.active.load())
+                return;
+            if (period.count() != 0)
+                task.period = period;
+            task.deadline = now + task.period;
+            s.wheel.schedule(task, deadline_tick(task.deadline));
+            break;
+        }
+    }
+
+    /**
+     * \brief 从时间轮与登记链表上摘下任务并释放登记的引用
+     */
+    void    unregister(_Shard &s, _Task &task)
+    {
+        s.wheel.cancel(task);
+        if (task.reg_prev)
+            task.reg_prev->reg_next = task.reg_next;
+        else
+            s.tasks = task.reg_next;
+        if (task.reg_next)
+            task.reg_next->reg_prev = task.reg_prev;
+        task.reg_prev = task.reg_next = nullptr;
+        task.registered = false;
+        task.active.store(false);
+        intrusive_ptr_release(&task);
+    }
+
+    /**
+     * \brief 按分片时间轮的下一个非空刻度设定定时器
+     */
+    void    arm(_Shard &s)
+    {
+        auto next = s.wheel.next_expiry();
+        if (next == timing_wheel::never()) {
+            s.started = false;
+            return;
+        }
+        if (s.started && next >= s.armed_tick)
+            return;
+        s.armed_tick = next;
+        s.timer.expires_at(origin + tick_len * static_cast<_Clock::rep>(next));
+        s.timer.async_wait(boost::bind(&sharded_timer::handler, this, &s, _1));
+        s.started = true;
+    }
+
+    /**
+     * \brief 分片定时器 handler，推进时间轮并执行到期的回调
+     */
+    void    handler(_Shard *s, const ERRCODE &ec)
+    {
+        if (ec)
+            return;
+
+        s->started = false;
+        auto now = _Clock::now();
+        std::vector<boost::intrusive_ptr<_Task>> fired;
+        fired.swap(s->fired);
+        s->wheel.advance(tick_of(now), [&](timer_node &n) {
+            auto &task = static_cast<_Task &>(n);
+            fired.emplace_back(&task);
+            reschedule(*s, task, now);
+        });
+        arm(*s);
+
+        for (auto &task : fired) {
+            /*其他线程的取消可能还在队列中*/
+            if (task->active.load())
+                task->doing();
+        }
+        fired.clear();
+        fired.swap(s->fired);
+    }
+
+    /**
+     * \brief 从上一次截止时间推算下一次，按策略处理错过的周期
+     */
+    void    reschedule(_Shard &s, _Task &task, _Clock::time_point now)
+    {
+        auto next = task.deadline + task.period;
+        if (next <= now) {
+            switch (task.policy) {
+            case catch_up::skip:
+                next += task.period * ((now - next) / task.period + 1);
+                break;
+            case catch_up::coalesce:
+                next = now + task.period;
+                break;
+            case catch_up::burst:
+                break;
+            }
+        }
+        task.deadline = next;
+        s.wheel.schedule(task, deadline_tick(next));
+    }
+
+    qword   tick_of(_Clock::time_point tp) const
+    {
+        return tp <= origin ? 0 : static_cast<qword>((tp - origin) / tick_len);
+    }
+
+    qword   deadline_tick(_Clock::time_point tp) const
+    {
+        return tp <= origin ? 0 : static_cast<qword>((tp - origin + tick_len - _Clock::duration(1)) / tick_len);
+    }
+
+    _Clock::duration    clamp_period(_Clock::duration period) const
+    {
+        return period < tick_len ? tick_len : period;
+    }
+
+    /**
+     * \brief 实例序号，用于线程局部的分片记录
+     */
+    const qword         serial{ next_serial() };
+    /**
+     * \brief 刻度长度与零点，各分片共用
+     */
+    _Clock::duration    tick_len;
+    _Clock::time_point  origin;
+    std::vector<std::unique_ptr<_Shard>>    shards;
+    /**
+     * \brief 非分片线程加入任务时轮流选择分片
+     */
+    std::atomic<size_t> next_shard{ 0 };
+};
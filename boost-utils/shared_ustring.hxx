@@ -0,0 +1,249 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月19日  11:31:47
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: shared_ustring.hxx
+//  描述: 引用计数共享字节串，切片共享同一块内存，写时复制
+// **************************************************************************/
+#pragma once
+
+#include "ustring_view.hxx"
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <stdexcept>
+#include <cstring>
+
+/**
+ * \brief 共享字节串
+ *
+ * 一次分配只带一个原子引用计数，拷贝与切片都只增加计数而不复制数据，
+ * 适合将同一份收到的数据分发给多个订阅者。内容本身只读，
+ * 需要修改时通过 mutable_data() 写时复制。
+ */
+class shared_ustring final {
+
+    /**
+     * \brief 内存块头部，数据紧跟在头部之后
+     */
+    struct _Block {
+        std::atomic<size_t> refs;
+
+        uchar *data() { return reinterpret_cast<uchar *>(this + 1); }
+    };
+
+public:
+    using value_type = uchar;
+    using size_type = size_t;
+    using const_iterator = const uchar *;
+    using iterator = const_iterator;
+
+    /**
+     * \brief 切片长度参数的“直到末尾”
+     */
+    static const size_type npos = static_cast<size_type>(-1);
+
+    shared_ustring() noexcept {}
+
+    /**
+     * \brief 从指针复制构造，只复制这一次
+     * \param ptr 指针
+     * \param len 长度
+     */
+    shared_ustring(const uchar *ptr, size_type len) {
+        if (len == 0)
+            return;
+        block = allocate(len);
+        std::memcpy(block->data(), ptr, len);
+        first = block->data();
+        count = len;
+    }
+
+    /**
+     * \brief 从字节串复制构造
+     * \param s 字节串
+     */
+    explicit shared_ustring(const ustring &s) : shared_ustring(s.data(), s.size()) {}
+
+    /**
+     * \brief 从视图复制构造
+     * \param v 视图
+     */
+    explicit shared_ustring(ustring_view v) : shared_ustring(v.data(), v.size()) {}
+
+    /**
+     * \brief 拷贝构造，只增加引用计数
+     * \param other
+     */
+    shared_ustring(const shared_ustring &other) noexcept
+        : block(other.block), first(other.first), count(other.count) {
+        retain();
+    }
+
+    /**
+     * \brief 右值拷贝 窃取
+     * \param other 右值
+     */
+    shared_ustring(shared_ustring &&other) noexcept
+        : block(other.block), first(other.first), count(other.count) {
+        other.block = nullptr;
+        other.first = nullptr;
+        other.count = 0;
+    }
+
+    ~shared_ustring() { release(); }
+
+    shared_ustring &operator=(const shared_ustring &other) noexcept {
+        shared_ustring(other).swap(*this);
+        return *this;
+    }
+
+    shared_ustring &operator=(shared_ustring &&other) noexcept {
+        shared_ustring(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    void swap(shared_ustring &other) noexcept {
+        std::swap(block, other.block);
+        std::swap(first, other.first);
+        std::swap(count, other.count);
+    }
+
+    /**
+     * \brief 取得一个共享同一块内存的切片，O(1)
+     * \param offset 起始偏移，超过长度抛出 std::out_of_range
+     * \param len 长度，超出部分截断
+     * \return 切片
+     */
+    shared_ustring slice(size_type offset, size_type len = npos) const {
+        if (offset > count)
+            throw std::out_of_range("shared_ustring::slice offset out of range");
+        shared_ustring r(*this);
+        r.first += offset;
+        r.count = std::min(len, count - offset);
+        return r;
+    }
+
+    const uchar *data() const noexcept { return first; }
+    size_type size() const noexcept { return count; }
+    size_type length() const noexcept { return count; }
+    bool empty() const noexcept { return count == 0; }
+
+    const_iterator begin() const noexcept { return first; }
+    const_iterator end() const noexcept { return first + count; }
+
+    uchar operator[](size_type i) const noexcept { return first[i]; }
+
+    /**
+     * \brief 当前引用计数，空串返回0
+     * \return 共享同一块内存的实例个数
+     */
+    size_type use_count() const noexcept {
+        return block ? block->refs.load(std::memory_order_acquire) : 0;
+    }
+
+    /**
+     * \brief 是否独占内存
+     * \return 是否独占
+     */
+    bool unique() const noexcept { return use_count() == 1; }
+
+    /**
+     * \brief 取得只读视图，视图有效期不能超过当前实例
+     * \return 视图
+     */
+    ustring_view view() const noexcept { return ustring_view(first, count); }
+
+    operator ustring_view() const noexcept { return view(); }
+
+    /**
+     * \brief 复制出一个普通字节串
+     * \return 字节串
+     */
+    ustring to_ustring() const { return ustring(first, count); }
+
+    /**
+     * \brief 取得可写指针，写时复制：与他人共享时先复制一份当前切片
+     * \return 可写指针
+     */
+    uchar *mutable_data() {
+        if (block && !unique())
+            shared_ustring(first, count).swap(*this);
+        return const_cast<uchar *>(first);
+    }
+
+    /**
+     * \brief 转化为十六进制字符串
+     * \param split_str 分割符
+     * \param is_upper 大小写
+     * \return 返回的字符串
+     */
+    std::string to_hexstring(const char *split_str = nullptr, bool is_upper = true) const {
+        static const char upper_digits[] = "0123456789ABCDEF";
+        static const char lower_digits[] = "0123456789abcdef";
+        auto digits = is_upper ? upper_digits : lower_digits;
+        auto split_len = split_str ? strlen(split_str) : 0;
+
+        /*直接转换视图内的字节，不复制出中间 ustring*/
+        std::string str;
+        str.reserve(count * (2 + split_len));
+        for (size_type i = 0; i < count; ++i) {
+            str.push_back(digits[first[i] >> 4]);
+            str.push_back(digits[first[i] & 0x0F]);
+            if (split_len)
+                str.append(split_str, split_len);
+        }
+        return str;
+    }
+
+private:
+
+    static _Block *allocate(size_type len) {
+        auto b = static_cast<_Block *>(::operator new(sizeof(_Block) + len));
+        new (&b->refs) std::atomic<size_t>(1);
+        return b;
+    }
+
+    void retain() noexcept {
+        if (block)
+            block->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release() noexcept {
+        if (block && block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            ::operator delete(block);
+        block = nullptr;
+    }
+
+    /**
+     * \brief 内存块，空串为空指针
+     */
+    _Block          *block{ nullptr };
+    /**
+     * \brief 切片起始位置
+     */
+    const uchar     *first{ nullptr };
+    /**
+     * \brief 切片长度
+     */
+    size_type       count{ 0 };
+};
+
+inline bool operator==(const shared_ustring &a, const shared_ustring &b) {
+    return a.view() == b.view();
+}
+
+inline bool operator!=(const shared_ustring &a, const shared_ustring &b) {
+    return !(a == b);
+}
+
+inline ustring &operator<<(ustring &s, const shared_ustring &ss) {
+    s.append(ss.data(), ss.size());
+    return s;
+}
+
+inline std::ostream &operator<<(std::ostream &o, const shared_ustring &s) {
+    write_hexstring(o, s.data(), s.size(), " ");
+    return o;
+}
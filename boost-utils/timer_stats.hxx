@@ -0,0 +1,164 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月21日  19:20:47
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: timer_stats.hxx
+//  描述: 定时器统计：延迟与回调耗时的对数直方图、触发计数与时间轮快照
+// **************************************************************************/
+#pragma once
+
+#include "timing_wheel.hxx"
+#include "types.hxx"
+#include <boost/noncopyable.hpp>
+#include <atomic>
+#include <chrono>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * \brief 对数直方图的快照
+ *
+ * 第0桶统计0，第 i 桶统计 [2^(i-1), 2^i) 纳秒，最后一桶包含更大的值。
+ */
+struct log2_histogram_snapshot {
+    enum : uint { buckets = 48 };
+
+    qword   counts[buckets] = {};
+
+    /**
+     * \brief 样本数
+     */
+    qword   total() const {
+        qword n = 0;
+        for (auto c : counts)
+            n += c;
+        return n;
+    }
+
+    /**
+     * \brief 分位数的上界（纳秒），精度为2倍
+     * \param q 分位，0~1
+     * \return 没有样本时返回0
+     */
+    qword   percentile(double q) const {
+        auto n = total();
+        if (n == 0)
+            return 0;
+        auto rank = static_cast<qword>(q * static_cast<double>(n));
+        if (rank >= n)
+            rank = n - 1;
+        qword seen = 0;
+        for (uint i = 0; i < buckets; ++i) {
+            seen += counts[i];
+            if (seen > rank)
+                return upper_bound(i);
+        }
+        return upper_bound(buckets - 1);
+    }
+
+    /**
+     * \brief 桶的上界（纳秒，不含）
+     */
+    static qword upper_bound(uint bucket) {
+        return bucket == 0 ? 1 : qword(1) << bucket;
+    }
+};
+
+/**
+ * \brief 对数直方图，记录为一次 relaxed 原子加，可在任意线程并发记录
+ */
+class log2_histogram final : boost::noncopyable {
+public:
+    enum : uint { buckets = log2_histogram_snapshot::buckets };
+
+    log2_histogram() {
+        for (auto &c : counts)
+            c.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief 记录一个值
+     * \param ns 纳秒
+     */
+    void record(qword ns) {
+        counts[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template<class _Rep, class _Period>
+    void record(std::chrono::duration<_Rep, _Period> d) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+        record(ns > 0 ? static_cast<qword>(ns) : 0);
+    }
+
+    log2_histogram_snapshot snapshot() const {
+        log2_histogram_snapshot s;
+        for (uint i = 0; i < buckets; ++i)
+            s.counts[i] = counts[i].load(std::memory_order_relaxed);
+        return s;
+    }
+
+    static uint bucket_of(qword ns) {
+        if (ns == 0)
+            return 0;
+#ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanReverse64(&idx, ns);
+        auto b = static_cast<uint>(idx) + 1;
+#else
+        auto b = static_cast<uint>(64 - __builtin_clzll(ns));
+#endif
+        return b < buckets ? b : buckets - 1;
+    }
+
+private:
+    std::atomic<qword>  counts[buckets];
+};
+
+/**
+ * \brief 定时器的累计统计，回调在线程池上执行时由任务共享持有
+ */
+class timer_stats final : boost::noncopyable {
+public:
+    /**
+     * \brief 实际触发时间减截止时间
+     */
+    log2_histogram      lateness;
+    /**
+     * \brief 回调耗时
+     */
+    log2_histogram      duration;
+    /**
+     * \brief 回调执行次数
+     */
+    std::atomic<qword>  fires{ 0 };
+};
+
+/**
+ * \brief 定时器快照
+ */
+struct timer_snapshot {
+    log2_histogram_snapshot lateness;
+    log2_histogram_snapshot duration;
+    qword   fires{ 0 };
+    /**
+     * \brief 因上一次回调未结束而跳过、排队的次数
+     */
+    qword   skipped{ 0 };
+    qword   queued{ 0 };
+    /**
+     * \brief 唤醒时已错过的刻度总数
+     */
+    qword   late_ticks{ 0 };
+    /**
+     * \brief 已登记的任务数与在时间轮上的任务数
+     */
+    size_t  registered{ 0 };
+    size_t  armed{ 0 };
+    /**
+     * \brief 时间轮各层的非空槽数
+     */
+    uint    occupancy[timing_wheel::levels] = {};
+};
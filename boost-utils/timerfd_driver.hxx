@@ -0,0 +1,168 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月21日  16:48:12
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: timerfd_driver.hxx
+//  描述: 基于 Linux timerfd 与 epoll 的定时器驱动，自带分发线程，不依赖 asio
+// **************************************************************************/
+#pragma once
+
+#include "forever_timer.hxx"
+
+#ifdef __linux__
+
+#include <boost/system/system_error.hpp>
+#include <boost/thread/thread.hpp>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+/**
+ * \brief timerfd 驱动
+ *
+ * 使用 CLOCK_MONOTONIC 的绝对时间单次定时（steady_clock 在 Linux 上即为该时钟），
+ * 分发线程在 epoll 上等待 timerfd 与用于停止的 eventfd。单次定时的到期次数总为1，
+ * 唤醒后读出清零并回调一次，错过的刻度由定时器按当前刻度与设定刻度之差在这一次回调中批量推进
+ * （见 late_ticks()）。创建失败时构造函数抛出 boost::system::system_error；
+ * 运行中 epoll_wait 出现 EINTR 以外的错误时分发线程退出、定时器不再触发，错误写到 stderr
+ * 并可由 failure() 查询。
+ */
+class timerfd_driver final : boost::noncopyable {
+public:
+    using _Clock = std::chrono::steady_clock;
+
+    timerfd_driver()
+    {
+        tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (tfd < 0 || efd < 0 || epfd < 0 || !watch(tfd) || !watch(efd)) {
+            auto err = errno;
+            close_all();
+            throw boost::system::system_error(
+                ERRCODE(err, boost::system::system_category()), "timerfd_driver");
+        }
+    }
+
+    ~timerfd_driver()
+    {
+        if (worker.joinable()) {
+            qword one = 1;
+            while (::write(efd, &one, sizeof(one)) < 0 && errno == EINTR)
+                ;
+            worker.join();
+        }
+        close_all();
+    }
+
+    /**
+     * \brief 设置唤醒回调并启动分发线程，构造后调用一次
+     */
+    void    open(const boost::function<void()> &on_expire)
+    {
+        expire = on_expire;
+        worker = boost::thread(boost::bind(&timerfd_driver::run, this));
+    }
+
+    /**
+     * \brief 设定唤醒时间，可在任意线程调用
+     */
+    void    arm(_Clock::time_point when)
+    {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+        /*全0表示停止定时器*/
+        if (ns <= 0)
+            ns = 1;
+        itimerspec its{};
+        its.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+        its.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+        timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, nullptr);
+    }
+
+    void    cancel()
+    {
+        itimerspec its{};
+        timerfd_settime(tfd, 0, &its, nullptr);
+    }
+
+    /**
+     * \brief 分发线程因错误退出时的错误码，正常运行时为空
+     */
+    ERRCODE failure() const
+    {
+        auto err = failed.load(std::memory_order_acquire);
+        return err ? ERRCODE(err, boost::system::system_category()) : ERRCODE();
+    }
+
+private:
+
+    /**
+     * \brief 把描述符加入 epoll，失败时 errno 保留错误
+     */
+    bool    watch(int fd)
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+    }
+
+    /**
+     * \brief 分发线程
+     */
+    void    run()
+    {
+        epoll_event events[2];
+        for (;;) {
+            auto n = epoll_wait(epfd, events, 2, -1);
+            if (n < 0) {
+                auto err = errno;
+                if (err == EINTR)
+                    continue;
+                /*EBADF、EINVAL 等都不会自行恢复，记下错误后退出，不在这里空转*/
+                failed.store(err, std::memory_order_release);
+                std::fprintf(stderr, "timerfd_driver: epoll_wait failed: %s, timer stopped\n", std::strerror(err));
+                return;
+            }
+            bool fire = false;
+            for (int i = 0; i < n; ++i) {
+                if (events[i].data.fd == efd)
+                    return;
+                qword count = 0;
+                if (::read(tfd, &count, sizeof(count)) == sizeof(count))
+                    fire = true;
+            }
+            if (fire)
+                expire();
+        }
+    }
+
+    void    close_all()
+    {
+        for (auto fd : { epfd, efd, tfd }) {
+            if (fd >= 0)
+                ::close(fd);
+        }
+    }
+
+    int                     tfd{ -1 };
+    int                     efd{ -1 };
+    int                     epfd{ -1 };
+    std::atomic<int>        failed{ 0 };
+    boost::function<void()> expire;
+    boost::thread           worker;
+};
+
+/**
+ * \brief 由 timerfd 驱动、自带分发线程的循环定时器，接口与 forever_timer 相同
+ */
+using fd_forever_timer = basic_forever_timer<timerfd_driver>;
+
+#endif
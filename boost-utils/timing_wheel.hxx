@@ -0,0 +1,303 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月21日  09:12:40
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: timing_wheel.hxx
+//  描述: 分层时间轮，O(1) 加入、取消与推进
+// **************************************************************************/
+#pragma once
+
+#include "types.hxx"
+#include <boost/noncopyable.hpp>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * \brief 时间轮节点，嵌入到定时任务中使用，不做额外分配
+ */
+struct timer_node {
+    timer_node  *prev{ nullptr };
+    timer_node  *next{ nullptr };
+    /**
+     * \brief 到期的刻度
+     */
+    qword       expire{ 0 };
+    /**
+     * \brief 所在的层与槽
+     */
+    uchar       level{ 0 };
+    uchar       slot{ 0 };
+
+    /**
+     * \brief 是否在时间轮中
+     */
+    bool armed() const { return next != nullptr; }
+};
+
+/**
+ * \brief 分层时间轮
+ *
+ * 共 levels 层，每层 64 个槽，第 k 层每个槽跨 64^k 个刻度，6 层可覆盖 2^36 个刻度，
+ * 更远的节点先放在最高层，轮转到时再重新放置。每层用一个 64 位图记录非空槽，
+ * 据此直接求出下一个有事可做的刻度，驱动方只需在该刻度唤醒一次。
+ * 节点用侵入式双向链表挂在槽上，加入与取消均为 O(1)；推进时整槽取下处理，
+ * 高层槽在低层转完一圈时整体下移。
+ *
+ * 时间轮本身不加锁，也不关心刻度对应的真实时间。
+ */
+class timing_wheel final : boost::noncopyable {
+public:
+    enum : uint {
+        slot_bits = 6,
+        slots = 1u << slot_bits,
+        levels = 6
+    };
+
+    /**
+     * \brief 表示没有待处理的刻度
+     */
+    static qword never() { return ~qword(0); }
+
+    /**
+     * \brief 构造
+     * \param start_tick 起始刻度
+     */
+    explicit timing_wheel(qword start_tick = 0) : elapsed(start_tick) {
+        for (uint l = 0; l < levels; ++l) {
+            bitmap[l] = 0;
+            for (uint s = 0; s < slots; ++s)
+                heads[l][s].prev = heads[l][s].next = &heads[l][s];
+        }
+    }
+
+    /**
+     * \brief 下一个待处理的刻度，小于它的刻度都已处理完
+     */
+    qword current() const { return elapsed; }
+
+    /**
+     * \brief 节点数
+     */
+    size_t size() const { return count; }
+
+    bool empty() const { return count == 0; }
+
+    /**
+     * \brief 某层的非空槽数
+     * \param level 层
+     */
+    uint occupancy(uint level) const { return popcount(bitmap[level]); }
+
+    /**
+     * \brief 加入或重新安排节点，已在轮中的节点先取下
+     * \param n 节点
+     * \param expire_tick 到期刻度，早于 current() 时按 current() 处理
+     */
+    void schedule(timer_node &n, qword expire_tick) {
+        if (n.armed())
+            remove(n);
+        n.expire = expire_tick < elapsed ? elapsed : expire_tick;
+        place(n);
+        ++count;
+    }
+
+    /**
+     * \brief 取消节点
+     * \param n 节点
+     * \return 节点原先在轮中返回true
+     */
+    bool cancel(timer_node &n) {
+        if (!n.armed())
+            return false;
+        remove(n);
+        return true;
+    }
+
+    /**
+     * \brief 推进到 now_tick（含），按刻度顺序回调到期节点
+     *
+     * 回调前节点已取下，回调中可以重新 schedule 该节点或增删其他节点；
+     * 回调中加入的已到期节点在下一个刻度处理。空刻度按位图直接跳过。
+     * \tparam _Func 回调类型，签名为 void(timer_node &)
+     * \param now_tick 当前刻度
+     * \param on_expire 回调
+     * \return 到期的节点数
+     */
+    template<class _Func>
+    size_t advance(qword now_tick, _Func &&on_expire) {
+        size_t fired = 0;
+        while (elapsed <= now_tick) {
+            auto t = elapsed;
+            auto idx = static_cast<uint>(t & (slots - 1));
+            if (idx == 0)
+                cascade(t);
+            elapsed = t + 1;
+            if (bitmap[0] & (qword(1) << idx)) {
+                /*整槽取下，挂到栈上的临时链表，回调中取消其中的节点也是安全的*/
+                timer_node local;
+                splice(heads[0][idx], local);
+                bitmap[0] &= ~(qword(1) << idx);
+                while (local.next != &local) {
+                    auto n = local.next;
+                    unlink(*n);
+                    --count;
+                    ++fired;
+                    on_expire(*n);
+                }
+            }
+            auto next = next_expiry();
+            if (next > elapsed)
+                elapsed = next < now_tick + 1 ? next : now_tick + 1;
+        }
+        return fired;
+    }
+
+    /**
+     * \brief 下一个需要推进的刻度：最近的到期槽或需要下移的高层槽
+     * \return 刻度，轮为空时返回 never()
+     */
+    qword next_expiry() const {
+        auto best = never();
+        for (uint l = 0; l < levels; ++l) {
+            if (!bitmap[l])
+                continue;
+            auto shift = l * slot_bits;
+            /*本层下一次处理的块号，第0层每块一个刻度*/
+            auto block = (elapsed + (qword(1) << shift) - 1) >> shift;
+            auto rot = static_cast<uint>(block & (slots - 1));
+            auto bits = rotate_right(bitmap[l], rot);
+            auto tick = (block + ctz64(bits)) << shift;
+            if (tick < best)
+                best = tick;
+        }
+        return best;
+    }
+
+private:
+
+    /**
+     * \brief 按距离选择层与槽，挂到槽尾
+     */
+    void place(timer_node &n) {
+        auto delta = n.expire - elapsed;
+        auto pos = n.expire;
+        uint level = 0;
+        if (delta >= slots) {
+            level = (63 - clz64(delta)) / slot_bits;
+            if (level >= levels) {
+                /*超出范围，先放最高层最远的槽*/
+                level = levels - 1;
+                pos = elapsed + (qword(1) << (levels * slot_bits)) - 1;
+            }
+        }
+        auto slot = static_cast<uint>((pos >> (level * slot_bits)) & (slots - 1));
+        auto &head = heads[level][slot];
+        n.level = static_cast<uchar>(level);
+        n.slot = static_cast<uchar>(slot);
+        n.prev = head.prev;
+        n.next = &head;
+        head.prev->next = &n;
+        head.prev = &n;
+        bitmap[level] |= qword(1) << slot;
+    }
+
+    void remove(timer_node &n) {
+        unlink(n);
+        --count;
+        auto &head = heads[n.level][n.slot];
+        if (head.next == &head)
+            bitmap[n.level] &= ~(qword(1) << n.slot);
+    }
+
+    static void unlink(timer_node &n) {
+        n.prev->next = n.next;
+        n.next->prev = n.prev;
+        n.prev = n.next = nullptr;
+    }
+
+    /**
+     * \brief 把 from 上的整条链表移到 to
+     */
+    static void splice(timer_node &from, timer_node &to) {
+        if (from.next == &from) {
+            to.prev = to.next = &to;
+            return;
+        }
+        to.next = from.next;
+        to.prev = from.prev;
+        to.next->prev = &to;
+        to.prev->next = &to;
+        from.prev = from.next = &from;
+    }
+
+    /**
+     * \brief 刻度 t 是 64^k 的整数倍时，把第 k 层对应槽中的节点重新放置，先高层后低层
+     */
+    void cascade(qword t) {
+        uint top = 0;
+        while (top + 1 < levels && (t & ((qword(1) << ((top + 1) * slot_bits)) - 1)) == 0)
+            ++top;
+        for (auto l = top; l >= 1; --l) {
+            auto slot = static_cast<uint>((t >> (l * slot_bits)) & (slots - 1));
+            if (!(bitmap[l] & (qword(1) << slot)))
+                continue;
+            timer_node local;
+            splice(heads[l][slot], local);
+            bitmap[l] &= ~(qword(1) << slot);
+            while (local.next != &local) {
+                auto n = local.next;
+                unlink(*n);
+                place(*n);
+            }
+        }
+    }
+
+    static qword rotate_right(qword v, uint r) {
+        return r ? (v >> r) | (v << (64 - r)) : v;
+    }
+
+    static uint ctz64(qword v) {
+#ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanForward64(&idx, v);
+        return static_cast<uint>(idx);
+#else
+        return static_cast<uint>(__builtin_ctzll(v));
+#endif
+    }
+
+    static uint clz64(qword v) {
+#ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanReverse64(&idx, v);
+        return static_cast<uint>(63 - idx);
+#else
+        return static_cast<uint>(__builtin_clzll(v));
+#endif
+    }
+
+    static uint popcount(qword v) {
+#ifdef _MSC_VER
+        return static_cast<uint>(__popcnt64(v));
+#else
+        return static_cast<uint>(__builtin_popcountll(v));
+#endif
+    }
+
+    /**
+     * \brief 各槽链表的哨兵
+     */
+    timer_node  heads[levels][slots];
+    /**
+     * \brief 各层非空槽位图
+     */
+    qword       bitmap[levels];
+    /**
+     * \brief 下一个待处理的刻度
+     */
+    qword       elapsed;
+    size_t      count{ 0 };
+};
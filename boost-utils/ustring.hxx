@@ -9,39 +9,63 @@
 #pragma once
 
 #include "types.hxx"
+#include "random_bytes.hxx"
+#include <cstring>
+#include <iterator>
+#include <ostream>
 #include <string>
+#include <type_traits>
 #include <boost/regex.hpp>
 
 using base_ustring = std::basic_string<uchar>;
 using ustringstream = std::basic_stringstream<uchar>;
 
 /**
- * \brief 字节串
+ * \brief 判断类型是否为迭代器，代替 MSVC 内部的 std::_Is_iterator，便于其他编译器使用
+ * \tparam _Iter 类型
  */
-class ustring final : public base_ustring {
+template<class _Iter, class = void>
+struct is_iterator : std::false_type {};
 
+template<class _Iter>
+struct is_iterator<_Iter, typename std::conditional<true, void,
+    typename std::iterator_traits<_Iter>::iterator_category>::type> : std::true_type {};
+
+/**
+ * \brief 字节串，分配器可替换
+ * \tparam _Alloc 分配器类型
+ */
+template<class _Alloc = std::allocator<uchar>>
+class basic_ustring final : public std::basic_string<uchar, std::char_traits<uchar>, _Alloc> {
+
+    /**
+     * \brief 基类定义
+     */
+    using _Base = std::basic_string<uchar, std::char_traits<uchar>, _Alloc>;
 
 public:
-    ustring() : base_ustring() {}
+    using typename _Base::size_type;
+
+    basic_ustring() : _Base() {}
 
     /**
      * \brief 通过十六进制字符串构造
      * \param s 十六进制字符串
      */
-    explicit ustring(const std::string &s) { from_hexstring(s); }
+    explicit basic_ustring(const std::string &s) { from_hexstring(s); }
 
     /**
      * \brief 初始化sz个0
      * \param sz 个数
      */
-    explicit ustring(size_t sz) : base_ustring(sz, '\0') {}
+    explicit basic_ustring(size_t sz) : _Base(sz, '\0') {}
 
     /**
      * \brief 初始化构造多个_Ch字符
      * \param _Count 个数
      * \param _Ch 字符
      */
-    ustring(size_type _Count, uchar _Ch) : base_ustring(_Count, _Ch) {}
+    basic_ustring(size_type _Count, uchar _Ch) : _Base(_Count, _Ch) {}
 
     /**
      * \brief 通过容器来构造
@@ -49,9 +73,9 @@ public:
      * \param v 容器
      */
     template<class _Container,
-        class = typename std::enable_if<std::_Is_iterator<typename _Container::iterator>::value,
+        class = typename std::enable_if<is_iterator<typename _Container::iterator>::value,
         void>::type>
-    explicit ustring(const _Container &v) : base_ustring(v.begin(), v.end()) {}
+    explicit basic_ustring(const _Container &v) : _Base(v.begin(), v.end()) {}
 
     /**
      * \brief 通过迭代器构造
@@ -60,49 +84,69 @@ public:
      * \param _end 结束
      */
     template<class _Iter,
-        class = typename std::enable_if<std::_Is_iterator<_Iter>::value,
+        class = typename std::enable_if<is_iterator<_Iter>::value,
         void>::type>
-    ustring(_Iter _begin, _Iter _end) : base_ustring(_begin, _end) {}
+    basic_ustring(_Iter _begin, _Iter _end) : _Base(_begin, _end) {}
 
     /**
      * \brief 通过uchar指针数组来构造
      * \param ptr 指针
      * \param _count 需要的长度
      */
-    ustring(const uchar *ptr, size_type _count) : base_ustring(ptr, _count) {}
+    basic_ustring(const uchar *ptr, size_type _count) : _Base(ptr, _count) {}
 
     /**
      * \brief 通过初始化列表来构造（C++11）
      * \param _Ilist 初始化列表
      */
-    ustring(std::initializer_list<uchar> _Ilist) : base_ustring(_Ilist) {}
+    basic_ustring(std::initializer_list<uchar> _Ilist) : _Base(_Ilist) {}
 
     
     /**
      * \brief 拷贝构造函数
      * \param other 
      */
-    ustring(const ustring &other) : base_ustring(other) { }
+    basic_ustring(const basic_ustring &other) : _Base(other) { }
 
     /**
      * \brief 右值拷贝 窃取
      * \param other 右值
      */
-    ustring(ustring && other) noexcept : base_ustring(std::move(other)) { }
+    basic_ustring(basic_ustring && other) noexcept : _Base(std::move(other)) { }
+
+    /**
+     * \brief 拷贝赋值，声明了拷贝构造后不会再隐式生成
+     * \param other
+     * \return 当前实例
+     */
+    basic_ustring &operator=(const basic_ustring &other) {
+        _Base::operator=(other);
+        return *this;
+    }
+
+    /**
+     * \brief 右值赋值 窃取
+     * \param other 右值
+     * \return 当前实例
+     */
+    basic_ustring &operator=(basic_ustring &&other) noexcept {
+        _Base::operator=(std::move(other));
+        return *this;
+    }
 
     /**
      * \brief 添加一个uint类型到尾部
      * \param value 要添加的值
      * \return 当前实例
      */
-    ustring &append_int(uint value) {
+    basic_ustring &append_int(uint value) {
         uchar purebyte[4];
         purebyte[0] = static_cast<uchar>(value >> 24 & 0xFF);
         purebyte[1] = static_cast<uchar>(value >> 16 & 0xFF);
         purebyte[2] = static_cast<uchar>(value >> 8 & 0xFF);
         purebyte[3] = static_cast<uchar>(value & 0xFF);
 
-        append(&purebyte[0], &purebyte[4]);
+        this->append(&purebyte[0], &purebyte[4]);
         return *this;
     }
 
@@ -111,12 +155,12 @@ public:
      * \param value 值
      * \return 当前实例
      */
-    ustring &append_short(ushort value) {
+    basic_ustring &append_short(ushort value) {
         uchar purebyte[2];
         purebyte[0] = static_cast<uchar>(value >> 8 & 0xFF);
         purebyte[1] = static_cast<uchar>(value & 0xFF);
 
-        append(&purebyte[0], &purebyte[2]);
+        this->append(&purebyte[0], &purebyte[2]);
         return *this;
     }
 
@@ -127,8 +171,8 @@ public:
     ushort pop_short() {
         if (this->length() < 2)
             return 0;
-        auto r = ustring(this->begin(), this->begin() + 2).to_ushort();
-        erase(this->begin(), this->begin() + 2);
+        auto r = basic_ustring(this->begin(), this->begin() + 2).to_ushort();
+        this->erase(this->begin(), this->begin() + 2);
         return r;
     }
 
@@ -139,8 +183,8 @@ public:
     uint pop_int() {
         if (this->length() < 4)
             return 0;
-        auto r = ustring(this->begin(), this->begin() + 4).to_uint();
-        erase(this->begin(), this->begin() + 4);
+        auto r = basic_ustring(this->begin(), this->begin() + 4).to_uint();
+        this->erase(this->begin(), this->begin() + 4);
         return r;
     }
 
@@ -149,11 +193,11 @@ public:
      * \param size 需要的字节数
      * \return 返回的字节串
      */
-    ustring pop(uint size) {
+    basic_ustring pop(uint size) {
         if (this->length() < size)
-            return ustring();
+            return basic_ustring();
 
-        auto r = ustring(this->begin(), this->begin() + size);
+        auto r = basic_ustring(this->begin(), this->begin() + size);
         this->erase(this->begin(), this->begin() + size);
         return std::move(r);
     }
@@ -199,7 +243,7 @@ public:
         std::string str;
 
         char buffer[4];
-        for (auto it = begin(); it != end(); ++it) {
+        for (auto it = this->begin(); it != this->end(); ++it) {
             memset(buffer, 0, 4);
 #ifdef WIN32
             sprintf_s(buffer, 4, "%02x", *it);
@@ -259,62 +303,118 @@ public:
      * \param d 十六进制字符串
      * \return 字节串
      */
-    static ustring gen_from_hexstring(const std::string &d) {
-        ustring str;
+    static basic_ustring gen_from_hexstring(const std::string &d) {
+        basic_ustring str;
         str.from_hexstring(d);
         return std::move(str);
     }
 
     /**
-     * \brief 生成随机字节串
+     * \brief 生成随机字节串，使用线程独立的快速随机数，不能用于密钥
      * \param sz 需要的长度
      * \return 返回随机字节串
      */
-    static ustring gen_random_ustring(size_t sz) {
-        ustring data;
-        srand(static_cast<unsigned int>(time(nullptr)));
-        for (size_t i = 0; i < sz; ++i) {
-            auto r = static_cast<uint>(rand() % 255);
-            data.push_back(static_cast<uchar>(r));
-        }
+    static basic_ustring gen_random_ustring(size_t sz) {
+        basic_ustring data(sz);
+        fast_random::fill(&data[0], sz);
+        return std::move(data);
+    }
+
+    /**
+     * \brief 生成加密安全的随机字节串，用于随机数、密钥等安全相关场合
+     * \param sz 需要的长度
+     * \return 返回随机字节串
+     */
+    static basic_ustring gen_secure_ustring(size_t sz) {
+        basic_ustring data(sz);
+        secure_random::fill(&data[0], sz);
         return std::move(data);
     }
 };
 
+/**
+ * \brief 默认分配器的字节串
+ */
+using ustring = basic_ustring<>;
+
 /*基本运算符重载*/
-inline ustring &operator<<(ustring &s, uchar c) {
+template<class _Alloc>
+inline basic_ustring<_Alloc> &operator<<(basic_ustring<_Alloc> &s, uchar c) {
     s.push_back(c);
     return s;
 }
 
-inline ustring &operator<<(ustring &s, uint d) {
+template<class _Alloc>
+inline basic_ustring<_Alloc> &operator<<(basic_ustring<_Alloc> &s, uint d) {
     s.append_int(d);
     return s;
 }
 
-inline ustring &operator<<(ustring &s, ushort d) {
+template<class _Alloc>
+inline basic_ustring<_Alloc> &operator<<(basic_ustring<_Alloc> &s, ushort d) {
     s.append_short(d);
     return s;
 }
 
-inline ustring &operator<<(ustring &s, const ustring &ss) {
-    s.append(ss);
+template<class _Alloc, class _Alloc2>
+inline basic_ustring<_Alloc> &operator<<(basic_ustring<_Alloc> &s, const basic_ustring<_Alloc2> &ss) {
+    s.append(ss.data(), ss.size());
     return s;
 }
 
-inline ustring &operator<<(ustring &s, const ustring &&ss) {
-    s.append(ss);
+template<class _Alloc, class _Alloc2>
+inline basic_ustring<_Alloc> &operator<<(basic_ustring<_Alloc> &s, const basic_ustring<_Alloc2> &&ss) {
+    s.append(ss.data(), ss.size());
     return s;
 }
 
-inline ustring &operator<<(ustring &s, const std::string d) {
-    ustring ss;
+template<class _Alloc>
+inline basic_ustring<_Alloc> &operator<<(basic_ustring<_Alloc> &s, const std::string d) {
+    basic_ustring<_Alloc> ss;
     ss.from_hexstring(d);
     s << ss;
     return s;
 }
 
-inline std::ostream &operator<<(std::ostream &o, const ustring &s) {
-    o << s.to_hexstring(" ");
+/**
+ * \brief 将字节以十六进制写入流，格式与 to_hexstring 相同，经栈上缓冲分段写出，不生成中间字符串
+ * \param o 输出流
+ * \param p 数据
+ * \param n 长度
+ * \param split_str 分割符
+ * \param is_upper 大小写
+ */
+inline void write_hexstring(std::ostream &o, const uchar *p, size_t n, const char *split_str = nullptr, bool is_upper = true) {
+    static const char upper_digits[] = "0123456789ABCDEF";
+    static const char lower_digits[] = "0123456789abcdef";
+    auto digits = is_upper ? upper_digits : lower_digits;
+    auto split_len = split_str ? strlen(split_str) : 0;
+
+    char buffer[512];
+    size_t used = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (used + 2 + split_len > sizeof(buffer)) {
+            o.write(buffer, static_cast<std::streamsize>(used));
+            used = 0;
+        }
+        buffer[used++] = digits[p[i] >> 4];
+        buffer[used++] = digits[p[i] & 0x0F];
+        if (split_len > sizeof(buffer) - 2) {
+            o.write(buffer, static_cast<std::streamsize>(used));
+            o.write(split_str, static_cast<std::streamsize>(split_len));
+            used = 0;
+        }
+        else if (split_len) {
+            memcpy(buffer + used, split_str, split_len);
+            used += split_len;
+        }
+    }
+    if (used)
+        o.write(buffer, static_cast<std::streamsize>(used));
+}
+
+template<class _Alloc>
+inline std::ostream &operator<<(std::ostream &o, const basic_ustring<_Alloc> &s) {
+    write_hexstring(o, s.data(), s.size(), " ");
     return o;
 }
\ No newline at end of file
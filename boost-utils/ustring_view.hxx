@@ -0,0 +1,60 @@
+﻿// **************************************************************************/
+//  作者: 陈雪飞<chenxuefei_pp@163.com>
+//  日期: 2026年10月19日  11:20:04
+//  工程: boost-utils
+//  程序: boost-utils
+//  文件: ustring_view.hxx
+//  描述: 字节串只读视图
+// **************************************************************************/
+#pragma once
+
+#include "ustring.hxx"
+#include <boost/utility/string_view.hpp>
+
+/**
+ * \brief 字节串只读视图，不持有内存，只记录指针与长度
+ */
+using ustring_view = boost::basic_string_view<uchar, std::char_traits<uchar>>;
+
+/**
+ * \brief 由字节串生成视图
+ * \param s 字节串，视图有效期不能超过字节串本身
+ * \return 视图
+ */
+inline ustring_view make_view(const ustring &s) {
+    return ustring_view(s.data(), s.size());
+}
+
+/**
+ * \brief 由指针生成视图
+ * \param ptr 指针
+ * \param len 长度
+ * \return 视图
+ */
+inline ustring_view make_view(const uchar *ptr, size_t len) {
+    return ustring_view(ptr, len);
+}
+
+/**
+ * \brief 将视图的内容追加到字节串尾部
+ * \param s 字节串
+ * \param v 视图
+ * \return 当前字节串
+ */
+inline ustring &operator<<(ustring &s, ustring_view v) {
+    s.append(v.data(), v.size());
+    return s;
+}
+
+/**
+ * \brief 遍历链式缓冲的每一段，不做复制
+ * \tparam _Chain 链式缓冲类型，任何元素可转换为 ustring_view 的容器，例如 std::vector<shared_ustring>
+ * \tparam _Func 回调类型，签名为 void(ustring_view)
+ * \param chain 链式缓冲
+ * \param f 回调
+ */
+template<class _Chain, class _Func>
+inline void for_each_segment(const _Chain &chain, _Func &&f) {
+    for (const auto &seg : chain)
+        f(static_cast<ustring_view>(seg));
+}